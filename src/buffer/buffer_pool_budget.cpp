@@ -0,0 +1,137 @@
+#include "buffer/buffer_pool_budget.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+BufferPoolBudget::~BufferPoolBudget() { StopPressureMonitor(); }
+
+void BufferPoolBudget::Register(BufferPoolManager *bpm) {
+  std::lock_guard<std::mutex> guard(latch_);
+  pools_.push_back(bpm);
+  Rebalance();
+}
+
+void BufferPoolBudget::Unregister(BufferPoolManager *bpm) {
+  std::lock_guard<std::mutex> guard(latch_);
+  pools_.erase(std::remove(pools_.begin(), pools_.end(), bpm), pools_.end());
+  Rebalance();
+}
+
+void BufferPoolBudget::SetBudget(size_t budget) {
+  std::lock_guard<std::mutex> guard(latch_);
+  budget_ = budget;
+  Rebalance();
+}
+
+void BufferPoolBudget::SetMemoryReserve(size_t reserve) {
+  std::lock_guard<std::mutex> guard(latch_);
+  reserve_ = reserve;
+  Rebalance();
+}
+
+size_t BufferPoolBudget::GetUsage() {
+  std::lock_guard<std::mutex> guard(latch_);
+  size_t usage = 0;
+  for (auto bpm : pools_) {
+    usage += bpm->GetPoolSize();
+  }
+  return usage;
+}
+
+void BufferPoolBudget::StartPressureMonitor(std::chrono::milliseconds interval) {
+  ASSERT(interval.count() > 0, "Pressure check interval must be positive.");
+  if (monitor_.joinable()) return;
+  stop_monitor_ = false;
+  monitor_ = std::thread(&BufferPoolBudget::MonitorPressure, this, interval);
+}
+
+void BufferPoolBudget::StopPressureMonitor() {
+  if (!monitor_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(monitor_latch_);
+    stop_monitor_ = true;
+  }
+  monitor_cv_.notify_all();
+  monitor_.join();
+}
+
+void BufferPoolBudget::MonitorPressure(std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(monitor_latch_);
+  while (!monitor_cv_.wait_for(lock, interval, [this] { return stop_monitor_; })) {
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      Rebalance();
+    }
+    lock.lock();
+  }
+}
+
+/**
+ * MemAvailable estimates how much memory can be allocated without swapping, counting the page cache which can be
+ * dropped, so it does not fall just because the db files are cached.
+ */
+size_t BufferPoolBudget::GetAvailableFrames() {
+  std::ifstream in("/proc/meminfo");
+  std::string key;
+  size_t kilobytes;
+  std::string unit;
+  while (in >> key >> kilobytes >> unit) {
+    if (key == "MemAvailable:") return kilobytes / (PAGE_SIZE / 1024);
+  }
+  return SIZE_MAX;
+}
+
+bool BufferPoolBudget::ParseMegabytes(const std::string &value, size_t *frames) {
+  // strtoull would accept a sign and wrap a negative value around
+  if (value.empty() || !std::all_of(value.begin(), value.end(), [](char c) { return isdigit(c) != 0; })) return false;
+  errno = 0;
+  unsigned long long megabytes = std::strtoull(value.c_str(), nullptr, 10);
+  if (errno == ERANGE || megabytes > SIZE_MAX / (1024 * 1024)) return false;
+  *frames = static_cast<size_t>(megabytes) * 1024 * 1024 / PAGE_SIZE;
+  return true;
+}
+
+/**
+ * Pools are served smallest maximum first, so that the share a small pool cannot take is split among the larger ones.
+ *
+ * Under memory pressure the budget is cut to what the pools use now, less what the available memory lacks to cover
+ * the reserve. Once the pools have shrunk by that much the available memory is back at the reserve and the next
+ * rebalance keeps them where they are, so they do not swing back and forth.
+ */
+void BufferPoolBudget::Rebalance() {
+  if (pools_.empty()) return;
+  size_t budget = budget_;
+  size_t available = GetAvailableFrames();
+  if (available != SIZE_MAX) {
+    size_t usage = 0;
+    for (auto bpm : pools_) {
+      usage += bpm->GetPoolSize();
+    }
+    size_t limit = available >= reserve_ ? usage + (available - reserve_)
+                                          : usage - std::min(usage, reserve_ - available);
+    budget = std::min(budget, limit);
+  }
+  std::vector<BufferPoolManager *> pools = pools_;
+  std::sort(pools.begin(), pools.end(), [](BufferPoolManager *a, BufferPoolManager *b) {
+    return a->GetMaxPoolSize() < b->GetMaxPoolSize();
+  });
+  std::vector<size_t> shares(pools.size());
+  size_t remaining = budget;
+  for (size_t i = 0; i < pools.size(); i++) {
+    size_t share = remaining / (pools.size() - i);
+    shares[i] = std::min(std::max<size_t>(share, MIN_BUFFER_POOL_SIZE), pools[i]->GetMaxPoolSize());
+    remaining -= std::min(remaining, shares[i]);
+  }
+  // shrink first, the frames they give back are what the growing pools take
+  for (size_t i = 0; i < pools.size(); i++) {
+    if (shares[i] < pools[i]->GetPoolSize()) pools[i]->Resize(shares[i]);
+  }
+  for (size_t i = 0; i < pools.size(); i++) {
+    if (shares[i] > pools[i]->GetPoolSize()) pools[i]->Resize(shares[i]);
+  }
+}
@@ -1,215 +1,383 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
+/** @return the share of instance index when num_frames frames are spread as evenly as possible over num_instances */
+static size_t InstanceShare(size_t num_frames, size_t num_instances, size_t index) {
+  // the first instances take the remainder
+  return num_frames / num_instances + (index < num_frames % num_instances ? 1 : 0);
+}
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type, size_t max_pool_size)
+    : pool_size_(pool_size), max_pool_size_(std::max(pool_size, max_pool_size)), disk_manager_(disk_manager) {
+  ASSERT(num_instances > 0 && num_instances <= pool_size, "Invalid number of buffer pool instances.");
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(InstanceShare(pool_size_, num_instances, i), disk_manager_,
+                                                       replacer_type, InstanceShare(max_pool_size_, num_instances, i)));
   }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  stop_warm_up_ = true;
+  WaitForWarmUp();
+  StopBackgroundFlusher();
+  StopPrefetcher();
+  for (auto instance : instances_) {
+    delete instance;
   }
-  delete[] pages_;
-  delete replacer_;
 }
-/**
- * Zat Implement
- * free_list first
- * then replacer
- * return INVALID_FRAME_ID if fail
- */
-frame_id_t BufferPoolManager::TryToFindFreePage() {
-  frame_id_t frame_ = INVALID_FRAME_ID;
-  if(!free_list_.empty()){
-    frame_ = free_list_.front();
-    free_list_.pop_front();
-  }
-  // LRU 换一个
-  else {
-    frame_id_t replace_frame_id;
-    if(replacer_->Victim(&replace_frame_id)) //有得换
-      frame_ = replace_frame_id;
+
+size_t BufferPoolManager::Resize(size_t pool_size) {
+  std::lock_guard<std::mutex> guard(resize_latch_);
+  pool_size = std::clamp(pool_size, instances_.size(), max_pool_size_);
+  size_t total = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    total += instances_[i]->Resize(InstanceShare(pool_size, instances_.size(), i));
   }
-  return frame_;
+  pool_size_ = total;
+  return total;
 }
-/**
- * Zat Implement
- */
+
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  std::lock_guard<std::recursive_mutex> guard(latch_);
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  auto it = page_table_.find(page_id);
-  if(it != page_table_.end()){
-    pages_[it->second].pin_count_++;
-    replacer_->Pin(it->second);
-    return &pages_[it->second];
-  }
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  else {
-    frame_id_t frame_ = TryToFindFreePage();
-
-    if(frame_ == INVALID_FRAME_ID) return nullptr;
-    // 2.     If R is dirty, write it back to the disk.
-    // 3.     Delete R from the page table and insert P.
-    if(pages_[frame_].page_id_ != INVALID_PAGE_ID) {
-      if(pages_[frame_].IsDirty())
-        disk_manager_->WritePage(pages_[frame_].page_id_, pages_[frame_].data_);
-      page_table_.erase(pages_[frame_].page_id_);    
-    }
+  return GetInstance(page_id)->FetchPage(page_id);
+}
 
-    page_table_[page_id] = frame_;
-    // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-    disk_manager_->ReadPage(page_id,pages_[frame_].data_);
-    pages_[frame_].pin_count_ = 1;
-    pages_[frame_].page_id_ = page_id;
-    pages_[frame_].is_dirty_ = false;
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return FetchPage(page_id, strategy, false);
+}
 
-    replacer_->Pin(frame_);
-    return &pages_[frame_];
+Page *BufferPoolManager::FetchPageForRead(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return FetchPage(page_id, strategy, true);
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy, bool read_only) {
+  if (strategy == nullptr) return GetInstance(page_id)->FetchPage(page_id, nullptr, read_only);
+  if (strategy->rings_.empty()) {
+    strategy->rings_.resize(instances_.size());
+    for (auto &ring : strategy->rings_) {
+      ring.capacity_ = std::max<size_t>(1, strategy->ring_size_ / instances_.size());
+    }
   }
+  size_t index = GetInstanceIndex(page_id);
+  return instances_[index]->FetchPage(page_id, &strategy->rings_[index], read_only);
+}
+
+PageGuard BufferPoolManager::FetchPageGuarded(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return {this, FetchPage(page_id, strategy, false)};
+}
+
+PageGuard BufferPoolManager::FetchPageGuardedForRead(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return {this, FetchPage(page_id, strategy, true)};
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  return {this, FetchPage(page_id, nullptr, true)};
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  return {this, FetchPage(page_id, nullptr, false)};
+}
+
+PageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id) {
+  PageGuard guard(this, NewPage(page_id));
+  guard.MarkDirty();
+  return guard;
 }
 
 /**
- * Zat Implement
+ * The page id is decided by the disk manager, so allocate first and then hand the page to the instance it routes to.
  */
 Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  std::lock_guard<std::recursive_mutex> guard(latch_);
-  // 0.   Make sure you call AllocatePage!
-  page_id = disk_manager_->AllocatePage();
-  
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  if(page_id == INVALID_PAGE_ID) return nullptr;
-
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  
-  frame_id_t frame_ = TryToFindFreePage();
+  page_id = AllocatePage();
+  if (page_id == INVALID_PAGE_ID) return nullptr;
 
+  Page *page = GetInstance(page_id)->NewPage(page_id);
   //没地方放的话要回收这个新开的页
-  if(frame_ == INVALID_FRAME_ID) {
-    disk_manager_->DeAllocatePage(page_id);
-    return nullptr;
-  }
-
-  //清除替换页
-  if(pages_[frame_].page_id_ != INVALID_PAGE_ID) {
-    if(pages_[frame_].IsDirty())
-      disk_manager_->WritePage(pages_[frame_].page_id_, pages_[frame_].data_);
-    page_table_.erase(pages_[frame_].page_id_);    
-  }
-  
-  
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  pages_[frame_].ResetMemory();
-  pages_[frame_].pin_count_ = 1;
-  pages_[frame_].is_dirty_ = true; //是否应该这么处理存疑 [by zat]
-  pages_[frame_].page_id_ = page_id;
-  page_table_[page_id] = frame_;
-  replacer_->Pin(frame_);
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  return &pages_[frame_];
+  if (page == nullptr) {
+    DeallocatePage(page_id);
+  }
+  return page;
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  std::lock_guard<std::recursive_mutex> guard(latch_);
+  return GetInstance(page_id)->DeletePage(page_id);
+}
 
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) return true;
-  
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  if(pages_[it->second].pin_count_ != 0) return false;
-  
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  pages_[it->second].pin_count_ = 0;
-  pages_[it->second].page_id_ = INVALID_PAGE_ID;
-  pages_[it->second].is_dirty_ = 0;
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+page_id_t BufferPoolManager::AllocatePage() {
+  int next_page_id = disk_manager_->AllocatePage();
+  return next_page_id;
+}
+
+void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
+  disk_manager_->DeAllocatePage(page_id);
+}
+
+bool BufferPoolManager::IsPageFree(page_id_t page_id) {
+  return disk_manager_->IsPageFree(page_id);
+}
+
+uint64_t BufferPoolManager::GetHitCount() {
+  uint64_t hits = 0;
+  for (auto instance : instances_) {
+    hits += instance->GetHitCount();
+  }
+  return hits;
+}
 
-  replacer_->Pin(it->second); // 防止它进lru_list
+uint64_t BufferPoolManager::GetMissCount() {
+  uint64_t misses = 0;
+  for (auto instance : instances_) {
+    misses += instance->GetMissCount();
+  }
+  return misses;
+}
 
-  free_list_.push_back(it->second);
-  page_table_.erase(it);
+void BufferPoolManager::StartBackgroundFlusher(std::chrono::milliseconds interval, double clean_ratio) {
+  ASSERT(interval.count() > 0, "Flush interval must be positive.");
+  if (flusher_.joinable()) return;
+  stop_flusher_ = false;
+  flusher_ = std::thread(&BufferPoolManager::BackgroundFlush, this, interval, clean_ratio);
+}
 
-  // 0.   Make sure you call DeallocatePage!
-  disk_manager_->DeAllocatePage(page_id); // 虽然是0但是应该是后面检查完了确实能删除再de allocate
-  return true;
+void BufferPoolManager::StopBackgroundFlusher() {
+  if (!flusher_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(flusher_latch_);
+    stop_flusher_ = true;
+  }
+  flusher_cv_.notify_all();
+  flusher_.join();
 }
 
 /**
- * Zat Implement
+ * Cleaning frames needs no durability point, the disk manager is only checkpointed every
+ * CHECKPOINT_INTERVAL_MS, which syncs the file if checksums are on.
  */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::recursive_mutex> guard(latch_);
-  
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) return false;
+void BufferPoolManager::BackgroundFlush(std::chrono::milliseconds interval, double clean_ratio) {
+  auto aio = disk_manager_->CreateAsyncIO();
+  auto next_checkpoint = std::chrono::steady_clock::now() + std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS);
+  std::unique_lock<std::mutex> lock(flusher_latch_);
+  while (!flusher_cv_.wait_for(lock, interval, [this] { return stop_flusher_; })) {
+    lock.unlock();
+    for (auto instance : instances_) {
+      instance->FlushDirtyPages(clean_ratio, aio.get());
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_checkpoint) {
+      disk_manager_->Checkpoint();
+      next_checkpoint = now + std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS);
+    }
+    lock.lock();
+  }
+}
 
-  frame_id_t frame_ = it->second;
+void BufferPoolManager::PrefetchPage(page_id_t page_id) {
+  PrefetchRange(page_id, 1);
+}
 
-  if (pages_[frame_].pin_count_ <= 0) return false;
+void BufferPoolManager::PrefetchRange(page_id_t first_page_id, size_t count) {
+  if (first_page_id < 0 || count == 0) return;
+  EnqueuePrefetch({first_page_id, count, nullptr});
+}
 
-  // 这个参数个人理解为由进程告诉manager进程中是否修改了page
-  if (is_dirty) pages_[frame_].is_dirty_ = true;
+void BufferPoolManager::PrefetchChain(page_id_t page_id, NextPageIdFn next_page_id) {
+  if (page_id == INVALID_PAGE_ID || prefetch_depth_ == 0) return;
+  EnqueuePrefetch({page_id, prefetch_depth_, next_page_id});
+}
 
-  pages_[frame_].pin_count_--;
-  if (pages_[frame_].pin_count_ == 0) replacer_->Unpin(frame_);
+/**
+ * A request is only useful while its reader has not caught up with it, so when the queue is full the oldest request
+ * is the one dropped.
+ */
+void BufferPoolManager::EnqueuePrefetch(const PrefetchRequest &request) {
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    if (stop_prefetcher_) return;
+    if (!prefetcher_.joinable()) {
+      prefetcher_ = std::thread(&BufferPoolManager::PrefetchWorker, this);
+    }
+    if (prefetch_queue_.size() >= MAX_PENDING_PREFETCHES) prefetch_queue_.pop_front();
+    prefetch_queue_.push_back(request);
+  }
+  prefetch_cv_.notify_one();
+}
 
-  return true;
+void BufferPoolManager::PrefetchWorker() {
+  auto aio = disk_manager_->CreateAsyncIO();
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return stop_prefetcher_ || !prefetch_queue_.empty(); });
+    if (stop_prefetcher_) break;
+    PrefetchRequest request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetch_busy_ = true;
+    lock.unlock();
+    RunPrefetch(request, aio.get());
+    lock.lock();
+    prefetch_busy_ = false;
+    prefetch_idle_cv_.notify_all();
+  }
 }
 
 /**
- * Zat Implement
+ * A chain is read one page at a time, since the next page is only known once the current one has been read. The
+ * pages of a range are known up front, so up to the queue depth of aio of them are read at the same time. Pages of a
+ * chain are known to be allocated, consecutive ids are checked against the disk bitmap so that no unallocated page is
+ * cached.
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  std::lock_guard<std::recursive_mutex> guard(latch_);
-  auto it = page_table_.find(page_id);
-  if(it == page_table_.end()) return false; // 不知道这里t/f的作用是什么 [by zat]
+void BufferPoolManager::RunPrefetch(const PrefetchRequest &request, AsyncIO *aio) {
+  page_id_t page_id = request.page_id_;
+  for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; i++) {
+    if (request.next_page_id_ == nullptr && IsPageFree(page_id)) break;
+    auto *instance = GetInstance(page_id);
+    bool loading;
+    Page *page = instance->StartPrefetch(page_id, &loading);
+    if (page == nullptr) break;  // the instance is fully pinned, reading ahead would not help
+    if (request.next_page_id_ != nullptr) {
+      if (loading) disk_manager_->ReadPage(page_id, page->GetData());
+      page_id_t next_page_id = request.next_page_id_(page);
+      if (loading) {
+        instance->FinishPrefetch(page, true);
+      } else {
+        instance->UnpinPage(page_id, false);
+      }
+      page_id = next_page_id;
+      continue;
+    }
+    if (loading) {
+      aio->SubmitRead(page_id, page->GetData(), [instance, page](bool ok) { instance->FinishPrefetch(page, ok); });
+    } else {
+      instance->UnpinPage(page_id, false);
+    }
+    page_id++;
+  }
+  aio->Wait();
+}
+
+void BufferPoolManager::StopPrefetcher() {
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    stop_prefetcher_ = true;
+    prefetch_queue_.clear();
+  }
+  prefetch_cv_.notify_all();
+  if (prefetcher_.joinable()) prefetcher_.join();
+}
 
-  //需要写回
-  disk_manager_->WritePage(pages_[it->second].page_id_,pages_[it->second].GetData());
-  pages_[it->second].is_dirty_ = false;
-  return true;
+void BufferPoolManager::WaitForPrefetches() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  prefetch_idle_cv_.wait(lock, [this] { return prefetch_queue_.empty() && !prefetch_busy_; });
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
-  return next_page_id;
+/**
+ * The lists of the instances are interleaved rank by rank, so that cutting the dump short keeps the hottest pages of
+ * every instance. The file is a magic word, the number of ids and the ids.
+ */
+size_t BufferPoolManager::DumpResidentPages(const std::string &path) {
+  std::vector<std::vector<page_id_t>> lists;
+  size_t num_pages = 0;
+  for (auto instance : instances_) {
+    lists.push_back(instance->GetResidentPages());
+    num_pages += lists.back().size();
+  }
+  std::vector<page_id_t> pages;
+  pages.reserve(num_pages);
+  for (size_t rank = 0; pages.size() < num_pages; rank++) {
+    for (const auto &list : lists) {
+      if (rank < list.size()) pages.push_back(list[rank]);
+    }
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  auto count = static_cast<uint32_t>(pages.size());
+  out.write(reinterpret_cast<const char *>(&WARM_UP_MAGIC), sizeof(WARM_UP_MAGIC));
+  out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  out.write(reinterpret_cast<const char *>(pages.data()), static_cast<std::streamsize>(pages.size() * sizeof(page_id_t)));
+  if (!out) {
+    LOG(WARNING) << "Failed to write the resident pages to " << path;
+    return 0;
+  }
+  return pages.size();
 }
 
-void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  disk_manager_->DeAllocatePage(page_id);
+void BufferPoolManager::StartWarmUp(const std::string &path) {
+  if (warmer_.joinable()) return;
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return;
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  std::vector<page_id_t> pages(std::min<size_t>(count, pool_size_));
+  in.read(reinterpret_cast<char *>(pages.data()), static_cast<std::streamsize>(pages.size() * sizeof(page_id_t)));
+  bool valid = in && magic == WARM_UP_MAGIC;
+  in.close();
+  remove(path.c_str());
+  if (!valid) {
+    LOG(WARNING) << "Ignoring the malformed dump of resident pages " << path;
+    return;
+  }
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  stop_warm_up_ = false;
+  warmer_ = std::thread(&BufferPoolManager::WarmUp, this, std::move(pages));
 }
 
-bool BufferPoolManager::IsPageFree(page_id_t page_id) {
-  return disk_manager_->IsPageFree(page_id);
+void BufferPoolManager::WaitForWarmUp() {
+  if (warmer_.joinable()) warmer_.join();
+}
+
+/**
+ * The pages are read like a range is read ahead, except that they are not meant for a scan and so are kept out of
+ * the rings. A page a query has loaded in the meantime is left as it is. A page stays claimed until its read has
+ * completed and a query asking for it waits meanwhile, so every read is handed to the kernel at once instead of when
+ * the queue fills up, and completed reads are published before the next page is started.
+ */
+void BufferPoolManager::WarmUp(std::vector<page_id_t> pages) {
+  auto aio = disk_manager_->CreateAsyncIO();
+  for (auto page_id : pages) {
+    if (stop_warm_up_) break;
+    if (page_id < 0 || IsPageFree(page_id)) continue;
+    auto *instance = GetInstance(page_id);
+    bool loading;
+    Page *page = instance->StartPrefetch(page_id, &loading, false);
+    if (page == nullptr) continue;
+    if (!loading) {
+      instance->UnpinPage(page_id, false);
+      continue;
+    }
+    aio->SubmitRead(page_id, page->GetData(), [this, instance, page](bool ok) {
+      instance->FinishPrefetch(page, ok);
+      if (ok) num_warm_up_pages_++;
+    });
+    aio->Submit();
+    aio->Poll();
+  }
+  aio->Wait();
 }
 
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   LOG(INFO) << "*** BEGIN CheckAllUnpinned ***";
+  WaitForPrefetches();  // pages being read ahead are pinned by the prefetcher
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      // LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-      LOG(ERROR) << "!!! LEAKED PAGE: page_id=" << pages_[i].page_id_
-                 << " pin_count=" << pages_[i].pin_count_;
-    }
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
   }
   LOG(INFO) << "*** END CheckAllUnpinned ***";
   return res;
-}
\ No newline at end of file
+}
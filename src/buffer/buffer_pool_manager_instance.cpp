@@ -0,0 +1,628 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type, size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      arena_(max_pool_size_),
+      disk_manager_(disk_manager),
+      page_table_(max_pool_size_) {
+  // the Page objects are built in place as they have no default constructor pointing into the arena, the ones of the
+  // frames not in use yet are left unbuilt and their memory untouched
+  pages_ = static_cast<Page *>(::operator new(sizeof(Page) * max_pool_size_, std::align_val_t(alignof(Page))));
+  for (num_frames_ = 0; num_frames_ < pool_size_; num_frames_++) {
+    new (&pages_[num_frames_]) Page(arena_.GetFrame(num_frames_));
+  }
+  frames_.reset(new FrameState[max_pool_size_]);
+  stripes_.reset(new HitStripe[NUM_HIT_STRIPES]);
+  for (size_t i = 0; i < NUM_HIT_STRIPES; i++) {
+    for (auto &reference : stripes_[i].references_) {
+      reference = INVALID_FRAME_ID;
+    }
+  }
+  replacer_ = CreateReplacer(replacer_type, max_pool_size_);
+  replacer_->Resize(pool_size_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID) FlushPage(pages_[i].page_id_);
+  }
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_, std::align_val_t(alignof(Page)));
+  delete replacer_;
+}
+
+Replacer *BufferPoolManagerInstance::CreateReplacer(ReplacerType replacer_type, size_t pool_size) {
+  switch (replacer_type) {
+    case ReplacerType::kCLOCK:
+      return new CLOCKReplacer(pool_size);
+    case ReplacerType::kLRUK:
+      return new LRUKReplacer(pool_size);
+    case ReplacerType::k2Q:
+      return new TwoQueueReplacer(pool_size);
+    case ReplacerType::kLRU:
+    default:
+      return new LRUReplacer(pool_size);
+  }
+}
+
+/**
+ * Zat Implement
+ * free_list first
+ * then replacer
+ * return INVALID_FRAME_ID if fail
+ *
+ * A free frame can only be pinned for a moment by a hit which looked it up just before it was freed, and which backs
+ * off at once. A victim pinned by a hit since it was last unpinned leaves the replacer until that hit unpins it.
+ */
+frame_id_t BufferPoolManagerInstance::TryToFindFreePage() {
+  frame_id_t frame_ = INVALID_FRAME_ID;
+  if(!free_list_.empty()){
+    frame_ = free_list_.front();
+    free_list_.pop_front();
+    while (!Claim(frame_)) std::this_thread::yield();
+    return frame_;
+  }
+  // LRU 换一个
+  ApplyReferences();
+  frame_id_t replace_frame_id;
+  while (replacer_->Victim(&replace_frame_id)) { //有得换
+    frames_[replace_frame_id].tracked_ = false;
+    if (Claim(replace_frame_id)) return replace_frame_id;
+  }
+  return frame_;
+}
+
+/**
+ * The oldest frame of the ring is reused only if it still holds the page the ring loaded into it and that page is not
+ * pinned, otherwise it has been taken over by someone else and simply leaves the ring.
+ */
+frame_id_t BufferPoolManagerInstance::TryToRecycleRingFrame(BufferRing *ring) {
+  if (ring->frames_.size() < ring->capacity_) return INVALID_FRAME_ID;
+  auto [frame_id, page_id] = ring->frames_.front();
+  ring->frames_.pop_front();
+  if (pages_[frame_id].page_id_ != page_id || !Claim(frame_id)) return INVALID_FRAME_ID;
+  Untrack(frame_id);  // it is about to be reloaded
+  return frame_id;
+}
+
+/**
+ * A prefetched frame read by a scan joins the scan's ring. Since the scan no longer misses, the ring cannot recycle its
+ * oldest frame on the next miss, so that frame goes straight back to the free list where the prefetcher finds it.
+ */
+void BufferPoolManagerInstance::AdoptIntoRing(BufferRing *ring, frame_id_t frame_id, page_id_t page_id) {
+  ring->frames_.emplace_back(frame_id, page_id);
+  while (ring->frames_.size() > ring->capacity_) {
+    auto [old_frame_id, old_page_id] = ring->frames_.front();
+    ring->frames_.pop_front();
+    Page &old_page = pages_[old_frame_id];
+    if (old_frame_id == frame_id || old_page.page_id_ != old_page_id || !Claim(old_frame_id)) continue;
+    if (old_page.is_dirty_) disk_manager_->WritePage(old_page_id, old_page.GetData());
+    page_table_.Erase(old_page_id);
+    old_page.page_id_ = INVALID_PAGE_ID;
+    old_page.is_dirty_ = false;
+    Untrack(old_frame_id);  // it is free now
+    Publish(old_frame_id, 0);
+    free_list_.push_back(old_frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::WaitForLoad(std::unique_lock<std::mutex> &lock, page_id_t page_id) {
+  loading_cv_.wait(lock, [this, page_id] { return loading_.count(page_id) == 0; });
+}
+
+/**
+ * The page id is checked once the pin is held, since a frame cannot be claimed while it is pinned.
+ */
+bool BufferPoolManagerInstance::TryPin(frame_id_t frame_id, page_id_t page_id) {
+  Page &page = pages_[frame_id];
+  if (page.pin_count_.fetch_add(1) < 0) {
+    page.pin_count_.fetch_sub(1);
+    return false;
+  }
+  if (page.page_id_ == page_id) return true;
+  if (DropPin(frame_id)) {
+    std::lock_guard<std::mutex> guard(latch_);
+    TrackIfIdle(frame_id);
+  }
+  return false;
+}
+
+/**
+ * Clearing tracked_ before claiming a victim and reading tracked_ after dropping the last pin makes sure that either
+ * the claim succeeds or the frame is put back, whichever of the two comes last.
+ */
+bool BufferPoolManagerInstance::DropPin(frame_id_t frame_id) {
+  return pages_[frame_id].pin_count_.fetch_sub(1) == 1 && !frames_[frame_id].tracked_;
+}
+
+void BufferPoolManagerInstance::TrackIfIdle(frame_id_t frame_id) {
+  Page &page = pages_[frame_id];
+  if (page.page_id_ == INVALID_PAGE_ID || page.pin_count_ != 0 || frames_[frame_id].tracked_) return;
+  frames_[frame_id].tracked_ = true;
+  replacer_->Unpin(frame_id);
+}
+
+void BufferPoolManagerInstance::Untrack(frame_id_t frame_id) {
+  frames_[frame_id].tracked_ = false;
+  replacer_->Pin(frame_id);
+}
+
+/**
+ * The queue is lossy, a hit overwriting a reference which has not been handed to the replacer yet clears that frame's
+ * reference bit, so its next hit is queued again.
+ */
+void BufferPoolManagerInstance::RecordHit(frame_id_t frame_id) {
+  HitStripe &stripe = ThisThreadStripe();
+  stripe.hits_.fetch_add(1, std::memory_order_relaxed);
+  auto &referenced = frames_[frame_id].referenced_;
+  if (referenced.load(std::memory_order_relaxed) || referenced.exchange(true)) return;
+  uint32_t index = stripe.next_reference_.fetch_add(1, std::memory_order_relaxed) % REFERENCE_QUEUE_SIZE;
+  frame_id_t dropped = stripe.references_[index].exchange(frame_id);
+  if (dropped != INVALID_FRAME_ID) frames_[dropped].referenced_ = false;
+}
+
+/**
+ * A hit is replayed as the pin and unpin it used to be, oldest first within each stripe. Frames out of the replacer
+ * are skipped, they rejoin it as recently used once they are unpinned.
+ */
+void BufferPoolManagerInstance::ApplyReferences() {
+  for (size_t s = 0; s < NUM_HIT_STRIPES; s++) {
+    HitStripe &stripe = stripes_[s];
+    uint32_t next = stripe.next_reference_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < REFERENCE_QUEUE_SIZE; i++) {
+      auto &reference = stripe.references_[(next + i) % REFERENCE_QUEUE_SIZE];
+      if (reference.load(std::memory_order_relaxed) == INVALID_FRAME_ID) continue;
+      frame_id_t frame_id = reference.exchange(INVALID_FRAME_ID);
+      if (frame_id == INVALID_FRAME_ID) continue;
+      frames_[frame_id].referenced_ = false;
+      if (!frames_[frame_id].tracked_) continue;
+      replacer_->Pin(frame_id);
+      replacer_->Unpin(frame_id);
+    }
+  }
+}
+
+/**
+ * Threads are dealt the stripes in turn as they first hit a page, so up to NUM_HIT_STRIPES threads never share one.
+ */
+BufferPoolManagerInstance::HitStripe &BufferPoolManagerInstance::ThisThreadStripe() {
+  static std::atomic<size_t> next_stripe{0};
+  static thread_local size_t stripe = NUM_HIT_STRIPES;
+  if (stripe == NUM_HIT_STRIPES) stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_HIT_STRIPES;
+  return stripes_[stripe];
+}
+
+uint64_t BufferPoolManagerInstance::GetHitCount() const {
+  uint64_t hits = 0;
+  for (size_t i = 0; i < NUM_HIT_STRIPES; i++) {
+    hits += stripes_[i].hits_.load(std::memory_order_relaxed);
+  }
+  return hits;
+}
+
+void BufferPoolManagerInstance::FinishHit(frame_id_t frame_id, BufferRing *ring, bool read_only) {
+  RecordHit(frame_id);
+  Page &page = pages_[frame_id];
+  if (!read_only && page.mapped_data_ != nullptr) {
+    memcpy(page.data_, page.mapped_data_, PAGE_SIZE);
+    page.mapped_data_.store(nullptr, std::memory_order_release);
+  }
+  if (frames_[frame_id].prefetched_) {
+    frames_[frame_id].prefetched_ = false;
+    if (ring != nullptr) AdoptIntoRing(ring, frame_id, page.page_id_);
+  }
+}
+
+/**
+ * Zat Implement
+ *
+ * A page which is only going to be read can point into the mapping of the db file instead of being copied into the
+ * frame. Such a frame is copied into data_ before anyone fetches it for writing, so a frame pointing into the mapping
+ * is never dirty.
+ *
+ * A hit outside of a scan is served without the latch, unless the frame has to be copied out of the mapping or was
+ * prefetched. Under the latch no frame holding page_id can be claimed once WaitForLoad returns.
+ */
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, BufferRing *ring, bool read_only) {
+  if (ring == nullptr) {
+    frame_id_t frame_id = page_table_.Find(page_id);
+    if (frame_id != INVALID_FRAME_ID && TryPin(frame_id, page_id)) {
+      Page &page = pages_[frame_id];
+      if ((read_only || page.mapped_data_ == nullptr) && !frames_[frame_id].prefetched_) {
+        RecordHit(frame_id);
+        return &page;
+      }
+      std::lock_guard<std::mutex> guard(latch_);
+      FinishHit(frame_id, ring, read_only);
+      return &page;
+    }
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForLoad(lock, page_id);
+  // 1.     Search the page table for the requested page (P).
+  // 1.1    If P exists, pin it and return it immediately.
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if(frame_id != INVALID_FRAME_ID){
+    pages_[frame_id].pin_count_++;
+    FinishHit(frame_id, ring, read_only);
+    return &pages_[frame_id];
+  }
+  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  //        Note that pages are always found from the free list first.
+  frame_id_t frame_ = ring == nullptr ? INVALID_FRAME_ID : TryToRecycleRingFrame(ring);
+  if(frame_ == INVALID_FRAME_ID) frame_ = TryToFindFreePage();
+
+  if(frame_ == INVALID_FRAME_ID) return nullptr;
+  num_misses_.fetch_add(1, std::memory_order_relaxed);
+  if(ring != nullptr) ring->frames_.emplace_back(frame_, page_id);
+  // 2.     If R is dirty, write it back to the disk.
+  // 3.     Delete R from the page table and insert P.
+  if(pages_[frame_].page_id_ != INVALID_PAGE_ID) {
+    if(pages_[frame_].IsDirty())
+      disk_manager_->WritePage(pages_[frame_].page_id_, pages_[frame_].GetData());
+    page_table_.Erase(pages_[frame_].page_id_);
+  }
+
+  pages_[frame_].page_id_ = page_id;
+  page_table_.Insert(page_id, frame_);
+  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  pages_[frame_].mapped_data_ = read_only ? disk_manager_->GetMappedPage(page_id) : nullptr;
+  if (pages_[frame_].mapped_data_ == nullptr) disk_manager_->ReadPage(page_id, pages_[frame_].data_);
+  pages_[frame_].is_dirty_ = false;
+  frames_[frame_].prefetched_ = false;
+
+  replacer_->SetPage(frame_, page_id);
+  replacer_->Pin(frame_);
+  Publish(frame_, 1);
+  return &pages_[frame_];
+}
+
+/**
+ * Zat Implement
+ */
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForLoad(lock, page_id);
+  // A range prefetch may have cached the page while it was still unallocated, drop that copy.
+  frame_id_t stale = page_table_.Find(page_id);
+  if (stale != INVALID_FRAME_ID && Claim(stale)) {
+    pages_[stale].page_id_ = INVALID_PAGE_ID;
+    pages_[stale].is_dirty_ = false;
+    Untrack(stale);
+    page_table_.Erase(page_id);
+    Publish(stale, 0);
+    free_list_.push_back(stale);
+  }
+  // 1.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+  //      If all the pages in the instance are pinned, return nullptr.
+  frame_id_t frame_ = TryToFindFreePage();
+  if(frame_ == INVALID_FRAME_ID) return nullptr;
+
+  //清除替换页
+  if(pages_[frame_].page_id_ != INVALID_PAGE_ID) {
+    if(pages_[frame_].IsDirty())
+      disk_manager_->WritePage(pages_[frame_].page_id_, pages_[frame_].GetData());
+    page_table_.Erase(pages_[frame_].page_id_);
+  }
+
+  // 2.   Update P's metadata, zero out memory and add P to the page table.
+  pages_[frame_].mapped_data_ = nullptr;
+  pages_[frame_].ResetMemory();
+  pages_[frame_].is_dirty_ = true; //是否应该这么处理存疑 [by zat]
+  pages_[frame_].page_id_ = page_id;
+  frames_[frame_].prefetched_ = false;
+  page_table_.Insert(page_id, frame_);
+  replacer_->SetPage(frame_, page_id);
+  replacer_->Pin(frame_);
+  Publish(frame_, 1);
+  // 3.   Return a pointer to P.
+  return &pages_[frame_];
+}
+
+/**
+ * TODO: Student Implement
+ */
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForLoad(lock, page_id);
+
+  // 1.   Search the page table for the requested page (P).
+  // 1.   If P does not exist, return true.
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == INVALID_FRAME_ID) return true;
+
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  if (!Claim(frame_id)) return false;
+
+  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  pages_[frame_id].is_dirty_ = false;
+  frames_[frame_id].prefetched_ = false;
+
+  Untrack(frame_id); // 防止它进lru_list
+
+  page_table_.Erase(page_id);
+  Publish(frame_id, 0);
+  free_list_.push_back(frame_id);
+
+  // 0.   Make sure you call DeallocatePage!
+  disk_manager_->DeAllocatePage(page_id); // 虽然是0但是应该是后面检查完了确实能删除再de allocate
+  return true;
+}
+
+/**
+ * Zat Implement
+ *
+ * The caller holds a pin, so the frame cannot change hands and the latch is only needed to put the frame back into the
+ * replacer. A lookup which finds nothing may have raced with an erase, only a lookup under the latch is conclusive.
+ */
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_ = page_table_.Find(page_id);
+  std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+  if (frame_ == INVALID_FRAME_ID) {
+    lock.lock();
+    frame_ = page_table_.Find(page_id);
+    if (frame_ == INVALID_FRAME_ID) return false;
+  }
+  Page &page = pages_[frame_];
+  if (page.page_id_ != page_id || page.pin_count_ <= 0) return false;
+
+  // 这个参数个人理解为由进程告诉manager进程中是否修改了page
+  // set before the pin is dropped, so that the page cannot be evicted without being written
+  if (is_dirty) page.is_dirty_ = true;
+
+  int pin_count = page.pin_count_;
+  do {
+    if (pin_count <= 0) return false;
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1 && !frames_[frame_].tracked_) {
+    if (!lock.owns_lock()) lock.lock();
+    TrackIfIdle(frame_);
+  }
+  return true;
+}
+
+/**
+ * Zat Implement
+ *
+ * The page is marked clean before it is written, a hit which changes it in the meantime marks it dirty again.
+ */
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForLoad(lock, page_id);
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if(frame_id == INVALID_FRAME_ID) return false; // 不知道这里t/f的作用是什么 [by zat]
+
+  //需要写回
+  pages_[frame_id].is_dirty_ = false;
+  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  return true;
+}
+
+/**
+ * The frame is claimed under the latch, the caller then reads the page with the latch released so that foreground
+ * requests are not held up by the read. Anyone asking for the page in the meantime waits in WaitForLoad, the claim
+ * keeps hits away.
+ */
+Page *BufferPoolManagerInstance::StartPrefetch(page_id_t page_id, bool *loading, bool read_ahead) {
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForLoad(lock, page_id);
+  *loading = false;
+  frame_id_t cached = page_table_.Find(page_id);
+  if (cached != INVALID_FRAME_ID) {
+    pages_[cached].pin_count_++;
+    return &pages_[cached];
+  }
+  frame_id_t frame_id = TryToFindFreePage();
+  if (frame_id == INVALID_FRAME_ID) return nullptr;
+  Page &page = pages_[frame_id];
+  if (page.page_id_ != INVALID_PAGE_ID) {
+    if (page.is_dirty_) disk_manager_->WritePage(page.page_id_, page.GetData());
+    page_table_.Erase(page.page_id_);
+  }
+  page.page_id_ = page_id;
+  page_table_.Insert(page_id, frame_id);
+  page.mapped_data_ = nullptr;
+  page.is_dirty_ = false;
+  frames_[frame_id].prefetched_ = read_ahead;
+  replacer_->SetPage(frame_id, page_id);
+  replacer_->Pin(frame_id);
+  loading_.insert(page_id);
+  *loading = true;
+  return &page;
+}
+
+/**
+ * Nobody else can have pinned the page while it was loading, so a page whose read failed can simply be dropped.
+ */
+void BufferPoolManagerInstance::FinishPrefetch(Page *page, bool ok) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  loading_.erase(page->page_id_);
+  loading_cv_.notify_all();
+  if (!ok) {
+    page_table_.Erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    frames_[frame_id].prefetched_ = false;
+    Publish(frame_id, 0);
+    free_list_.push_back(frame_id);
+    return;
+  }
+  Publish(frame_id, 0);
+  TrackIfIdle(frame_id);
+}
+
+/**
+ * The candidates are the dirty pages nearest to eviction, taken from the replacer under the latch. They are written in
+ * batches: a batch is claimed under the latch, then written with the latch released, all at the same time when aio is
+ * given. The claim keeps hits and evictions away from a frame until its write has completed, a request for the page
+ * under the latch waits in WaitForLoad meanwhile. A candidate which is pinned, clean or evicted by then is skipped.
+ * Logical page ids map to physical pages in the same order, so sorting the candidates by page id keeps the writes close
+ * to sequential.
+ */
+size_t BufferPoolManagerInstance::FlushDirtyPages(double clean_ratio, AsyncIO *aio) {
+  std::vector<page_id_t> candidates;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    size_t num_dirty = 0;
+    for (size_t i = 0; i < num_frames_; i++) {
+      if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_) num_dirty++;
+    }
+    auto max_dirty = static_cast<size_t>(static_cast<double>(pool_size_.load()) * (1.0 - clean_ratio));
+    if (num_dirty <= max_dirty) return 0;
+    ApplyReferences();
+    for (auto frame_id : replacer_->GetVictimOrder()) {
+      if (candidates.size() == num_dirty - max_dirty) break;
+      Page &page = pages_[frame_id];
+      if (page.page_id_ == INVALID_PAGE_ID || !page.is_dirty_ || page.pin_count_ != 0) continue;
+      candidates.push_back(page.page_id_);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  size_t num_written = 0;
+  size_t batch_size = aio == nullptr ? 1 : aio->GetQueueDepth();
+  std::vector<frame_id_t> claimed;
+  for (size_t begin = 0; begin < candidates.size(); begin += batch_size) {
+    claimed.clear();
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      for (size_t i = begin; i < std::min(begin + batch_size, candidates.size()); i++) {
+        frame_id_t frame_id = page_table_.Find(candidates[i]);
+        if (frame_id == INVALID_FRAME_ID) continue;
+        Page &page = pages_[frame_id];
+        if (!page.is_dirty_ || !Claim(frame_id)) continue;
+        claimed.push_back(frame_id);
+        page.is_dirty_ = false;
+        loading_.insert(candidates[i]);
+      }
+    }
+    for (auto frame_id : claimed) {
+      Page &page = pages_[frame_id];
+      if (aio == nullptr) {
+        disk_manager_->WritePage(page.page_id_, page.GetData());
+        num_written++;
+        continue;
+      }
+      aio->SubmitWrite(page.page_id_, page.GetData(), [&page, &num_written](bool ok) {
+        if (!ok) {
+          page.is_dirty_ = true;
+          return;
+        }
+        num_written++;
+      });
+    }
+    if (aio != nullptr) aio->Wait();
+    std::lock_guard<std::mutex> guard(latch_);
+    for (auto frame_id : claimed) {
+      loading_.erase(pages_[frame_id].page_id_);
+      Publish(frame_id, 0);
+      // an eviction which picked the frame meanwhile took it out of the replacer
+      TrackIfIdle(frame_id);
+    }
+    loading_cv_.notify_all();
+  }
+  return num_written;
+}
+
+/**
+ * A frame taken by a shrink keeps its Page but stays claimed on the retired list, so that a hit which found it through
+ * a stale lookup backs off. Growing reuses retired frames before building new ones.
+ */
+size_t BufferPoolManagerInstance::Resize(size_t pool_size) {
+  std::lock_guard<std::mutex> guard(latch_);
+  pool_size = std::clamp<size_t>(pool_size, 1, max_pool_size_);
+  size_t current = pool_size_;
+  while (current < pool_size) {
+    frame_id_t frame_id;
+    if (!retired_.empty()) {
+      frame_id = retired_.back();
+      retired_.pop_back();
+      Publish(frame_id, 0);
+    } else {
+      frame_id = static_cast<frame_id_t>(num_frames_++);
+      new (&pages_[frame_id]) Page(arena_.GetFrame(frame_id));
+    }
+    free_list_.push_back(frame_id);
+    current++;
+  }
+  while (current > pool_size) {
+    frame_id_t frame_id = TryToFindFreePage();
+    if (frame_id == INVALID_FRAME_ID) break;
+    Page &page = pages_[frame_id];
+    if (page.page_id_ != INVALID_PAGE_ID) {
+      if (page.is_dirty_) disk_manager_->WritePage(page.page_id_, page.GetData());
+      page_table_.Erase(page.page_id_);
+      page.page_id_ = INVALID_PAGE_ID;
+      page.is_dirty_ = false;
+      page.mapped_data_ = nullptr;
+      frames_[frame_id].prefetched_ = false;
+    }
+    arena_.Release(frame_id);
+    retired_.push_back(frame_id);
+    current--;
+  }
+  pool_size_ = current;
+  replacer_->Resize(current);
+  return current;
+}
+
+// Only used for debug
+/**
+ * Unpinned pages the replacer does not track, like the pages held by the ring of a scan, are the coldest of all.
+ */
+std::vector<page_id_t> BufferPoolManagerInstance::GetResidentPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  ApplyReferences();
+  std::vector<page_id_t> pages;
+  std::vector<bool> listed(num_frames_, false);
+  for (size_t i = 0; i < num_frames_; i++) {
+    if (pages_[i].page_id_ == INVALID_PAGE_ID || pages_[i].pin_count_ == 0) continue;
+    pages.push_back(pages_[i].page_id_);
+    listed[i] = true;
+  }
+  auto victims = replacer_->GetVictimOrder();
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) {
+    if (pages_[*it].page_id_ == INVALID_PAGE_ID || listed[*it]) continue;
+    pages.push_back(pages_[*it].page_id_);
+    listed[*it] = true;
+  }
+  for (size_t i = 0; i < num_frames_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && !listed[i]) pages.push_back(pages_[i].page_id_);
+  }
+  return pages;
+}
+
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  std::lock_guard<std::mutex> guard(latch_);
+  bool res = true;
+  for (size_t i = 0; i < num_frames_; i++) {
+    // a retired frame stays claimed
+    if (pages_[i].page_id_ == INVALID_PAGE_ID && pages_[i].pin_count_ == CLAIMED_PIN_COUNT) continue;
+    if (pages_[i].pin_count_ != 0) {
+      res = false;
+      // LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+      LOG(ERROR) << "!!! LEAKED PAGE: page_id=" << pages_[i].page_id_
+                 << " pin_count=" << pages_[i].pin_count_;
+    }
+  }
+  return res;
+}
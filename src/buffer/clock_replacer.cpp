@@ -61,4 +61,24 @@ void CLOCKReplacer::Unpin(frame_id_t frame_id) {
 std::size_t CLOCKReplacer::Size() {
     std::lock_guard<std::recursive_mutex> guard(latch_);
     return clock_list.size();
-}
\ No newline at end of file
+}
+/**
+ * The hand clears the frames which were referenced on its first round and takes them on its second one, both rounds
+ * starting at the hand.
+ */
+std::vector<frame_id_t> CLOCKReplacer::GetVictimOrder() {
+    std::lock_guard<std::recursive_mutex> guard(latch_);
+    std::vector<frame_id_t> order;
+    std::vector<frame_id_t> referenced;
+    auto it = pointer == clock_list.end() ? clock_list.begin() : pointer;
+    for (size_t i = 0; i < clock_list.size(); i++) {
+        if (clock_status[*it] != 0) {
+            referenced.push_back(*it);
+        } else {
+            order.push_back(*it);
+        }
+        if (++it == clock_list.end()) it = clock_list.begin();
+    }
+    order.insert(order.end(), referenced.begin(), referenced.end());
+    return order;
+}
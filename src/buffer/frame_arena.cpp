@@ -0,0 +1,41 @@
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+FrameArena::FrameArena(size_t num_frames, bool huge_pages) : num_frames_(num_frames) {
+  size_t size = num_frames_ * PAGE_SIZE;
+  if (size == 0) return;
+  // a pool smaller than a huge page would only waste the rest of it
+  huge_pages = huge_pages && size >= HUGE_PAGE_SIZE;
+  // over-map by a huge page so the frames can start on a huge page boundary
+  region_size_ = huge_pages ? size + HUGE_PAGE_SIZE : size;
+  void *region = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  region_ = static_cast<char *>(region);
+  base_ = region_;
+  if (!huge_pages) return;
+  auto address = reinterpret_cast<uintptr_t>(region_);
+  base_ = reinterpret_cast<char *>((address + HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1));
+#ifdef MADV_HUGEPAGE
+  huge_pages_ = madvise(base_, size, MADV_HUGEPAGE) == 0;
+#endif
+}
+
+/**
+ * Inside a huge page this splits it, the rest of the huge page stays backed.
+ */
+void FrameArena::Release(frame_id_t frame_id) {
+  if (madvise(GetFrame(frame_id), PAGE_SIZE, MADV_DONTNEED) != 0) {
+    memset(GetFrame(frame_id), 0, PAGE_SIZE);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (region_ != nullptr) munmap(region_, region_size_);
+}
@@ -0,0 +1,79 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : max_capacity_(num_pages), k_(k) {}
+
+LRUKReplacer::EvictKey LRUKReplacer::KeyOf(const FrameHistory &history) const {
+  // fewer than K references: +inf distance, break ties by the earliest reference
+  // K references: the older the K-th reference, the larger the backward K-distance
+  return {history.refs_.size() >= k_, history.refs_.empty() ? 0 : history.refs_.back()};
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (evictable_.empty()) return false;
+
+  auto victim = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  histories_.erase(victim);
+  if (last_frame_ == victim) last_frame_ = INVALID_FRAME_ID;
+  *frame_id = victim;
+  return true;
+}
+
+/**
+ * A pin is a reference to the frame.
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto &history = histories_[frame_id];
+  if (history.evictable_) {
+    evictable_.erase({KeyOf(history), frame_id});
+    history.evictable_ = false;
+  }
+  ++current_ts_;
+  if (last_frame_ == frame_id && !history.refs_.empty()) {
+    // correlated reference, only refresh it
+    history.refs_.front() = current_ts_;
+  } else {
+    history.refs_.push_front(current_ts_);
+    if (history.refs_.size() > k_) history.refs_.pop_back();
+  }
+  last_frame_ = frame_id;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto &history = histories_[frame_id];
+  if (history.evictable_ || evictable_.size() >= max_capacity_) return;
+  history.evictable_ = true;
+  evictable_.emplace(KeyOf(history), frame_id);
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_.size();
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetVictimOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> order;
+  order.reserve(evictable_.size());
+  for (const auto &entry : evictable_) {
+    order.push_back(entry.second);
+  }
+  return order;
+}
+
+/**
+ * A frame getting a new page starts with an empty history.
+ */
+void LRUKReplacer::SetPage(frame_id_t frame_id, [[maybe_unused]] page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = histories_.find(frame_id);
+  if (it == histories_.end()) return;
+  if (it->second.evictable_) {
+    evictable_.erase({KeyOf(it->second), frame_id});
+  }
+  histories_.erase(it);
+  if (last_frame_ == frame_id) last_frame_ = INVALID_FRAME_ID;
+}
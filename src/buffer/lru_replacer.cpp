@@ -58,4 +58,8 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
 size_t LRUReplacer::Size() {
   std::lock_guard<std::recursive_mutex> guard(latch_);
   return lru_list.size();
-}
\ No newline at end of file
+}
+std::vector<frame_id_t> LRUReplacer::GetVictimOrder() {
+  std::lock_guard<std::recursive_mutex> guard(latch_);
+  return std::vector<frame_id_t>(lru_list.begin(), lru_list.end());
+}
@@ -0,0 +1,62 @@
+#include "buffer/page_guard.h"
+
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+PageGuard::PageGuard(PageGuard &&that) noexcept : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&that) noexcept {
+  if (this == &that) return *this;
+  Drop();
+  bpm_ = that.bpm_;
+  page_ = that.page_;
+  is_dirty_ = that.is_dirty_;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+  return *this;
+}
+
+void PageGuard::Drop() {
+  if (page_ == nullptr) return;
+  bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+ReadPageGuard::ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+  if (page != nullptr) page->RLatch();
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this == &that) return *this;
+  Drop();
+  guard_ = std::move(that.guard_);
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (!guard_.IsValid()) return;
+  guard_.GetPage()->RUnlatch();
+  guard_.Drop();
+}
+
+WritePageGuard::WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+  if (page != nullptr) page->WLatch();
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this == &that) return *this;
+  Drop();
+  guard_ = std::move(that.guard_);
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (!guard_.IsValid()) return;
+  guard_.GetPage()->WUnlatch();
+  guard_.Drop();
+}
@@ -0,0 +1,66 @@
+#include "buffer/page_table.h"
+
+#include "common/macros.h"
+
+PageTable::PageTable(size_t num_frames) {
+  capacity_ = 2;
+  shift_ = 63;
+  while (capacity_ < num_frames * 2) {
+    capacity_ <<= 1;
+    shift_--;
+  }
+  mask_ = capacity_ - 1;
+  slots_.reset(new std::atomic<uint64_t>[capacity_]);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+frame_id_t PageTable::Find(page_id_t page_id) const {
+  size_t index = Home(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    uint64_t slot = slots_[index].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) break;
+    if (SlotPageId(slot) == page_id) return SlotFrameId(slot);
+    index = (index + 1) & mask_;
+  }
+  return INVALID_FRAME_ID;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  ASSERT(page_id >= 0, "Invalid page id.");
+  size_t index = Home(page_id);
+  while (slots_[index].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+    index = (index + 1) & mask_;
+  }
+  slots_[index].store(MakeSlot(page_id, frame_id), std::memory_order_release);
+}
+
+/**
+ * Instead of leaving a tombstone, the entries following the erased one in its probe sequence are shifted back over the
+ * hole, so lookups never get slower as pages come and go. An entry is only moved to a slot its own probe sequence
+ * passes, a reader racing with the shift may see an entry twice or miss it.
+ */
+bool PageTable::Erase(page_id_t page_id) {
+  size_t hole = Home(page_id);
+  while (true) {
+    uint64_t slot = slots_[hole].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) return false;
+    if (SlotPageId(slot) == page_id) break;
+    hole = (hole + 1) & mask_;
+  }
+  size_t index = hole;
+  while (true) {
+    index = (index + 1) & mask_;
+    uint64_t slot = slots_[index].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) break;
+    size_t home = Home(SlotPageId(slot));
+    // the entry stays if its home lies cyclically in (hole, index]
+    bool stays = hole <= index ? (hole < home && home <= index) : (hole < home || home <= index);
+    if (stays) continue;
+    slots_[hole].store(slot, std::memory_order_release);
+    hole = index;
+  }
+  slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+  return true;
+}
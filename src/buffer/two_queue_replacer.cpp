@@ -0,0 +1,127 @@
+#include "buffer/two_queue_replacer.h"
+
+/**
+ * The paper suggests Kin = 25% and Kout = 50% of the buffer.
+ */
+TwoQueueReplacer::TwoQueueReplacer(size_t num_pages)
+    : max_capacity_(num_pages),
+      kin_(num_pages / 4 > 0 ? num_pages / 4 : 1),
+      kout_(num_pages / 2 > 0 ? num_pages / 2 : 1) {}
+
+/**
+ * The shares of the queues follow the pool, a shrunk pool forgets the oldest pages of A1out at once.
+ */
+void TwoQueueReplacer::Resize(size_t num_pages) {
+  std::lock_guard<std::mutex> guard(latch_);
+  kin_ = num_pages / 4 > 0 ? num_pages / 4 : 1;
+  kout_ = num_pages / 2 > 0 ? num_pages / 2 : 1;
+  while (a1out_.size() > kout_) {
+    a1out_map_.erase(a1out_.front());
+    a1out_.pop_front();
+  }
+}
+
+void TwoQueueReplacer::Place(FrameInfo *info) { info->seq_ = next_seq_++; }
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) return;
+  auto &info = it->second;
+  if (info.evictable_) QueueOf(info).erase(info.seq_);
+  if (!info.in_am_) a1in_size_--;
+  frames_.erase(it);
+}
+
+bool TwoQueueReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (a1in_.empty() && am_.empty()) return false;
+
+  // reclaim from A1in while it is over its share, the hot set in Am is only touched otherwise
+  bool from_in = !a1in_.empty() && (a1in_size_ > kin_ || am_.empty());
+  frame_id_t victim = (from_in ? a1in_ : am_).begin()->second;
+
+  auto &info = frames_[victim];
+  if (!info.in_am_ && info.page_id_ != INVALID_PAGE_ID) {
+    // remember the page so that a second reference promotes it to Am
+    a1out_.push_back(info.page_id_);
+    a1out_map_[info.page_id_] = std::prev(a1out_.end());
+    if (a1out_.size() > kout_) {
+      a1out_map_.erase(a1out_.front());
+      a1out_.pop_front();
+    }
+  }
+  Remove(victim);
+  *frame_id = victim;
+  return true;
+}
+
+/**
+ * A pinned frame leaves its queue. A frame of Am is placed anew, since Am is ordered by recency, while a frame of A1in
+ * keeps its place, re-references there are ignored.
+ */
+void TwoQueueReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    // first reference of a frame the buffer pool did not announce, treat it as a new page
+    Place(&frames_[frame_id]);
+    a1in_size_++;
+    return;
+  }
+  auto &info = it->second;
+  if (info.evictable_) {
+    info.evictable_ = false;
+    QueueOf(info).erase(info.seq_);
+  }
+  if (info.in_am_) Place(&info);
+}
+
+void TwoQueueReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end() || it->second.evictable_ || a1in_.size() + am_.size() >= max_capacity_) return;
+  auto &info = it->second;
+  info.evictable_ = true;
+  QueueOf(info).emplace(info.seq_, frame_id);
+}
+
+size_t TwoQueueReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return a1in_.size() + am_.size();
+}
+
+/**
+ * Follows Victim: A1in is drained down to its share first, then Am, then the rest of A1in.
+ */
+std::vector<frame_id_t> TwoQueueReplacer::GetVictimOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> order;
+  order.reserve(a1in_.size() + am_.size());
+  auto in = a1in_.begin();
+  for (size_t in_size = a1in_size_; in_size > kin_ && in != a1in_.end(); in_size--, ++in) {
+    order.push_back(in->second);
+  }
+  for (const auto &entry : am_) {
+    order.push_back(entry.second);
+  }
+  for (; in != a1in_.end(); ++in) {
+    order.push_back(in->second);
+  }
+  return order;
+}
+
+void TwoQueueReplacer::SetPage(frame_id_t frame_id, page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Remove(frame_id);
+  auto &info = frames_[frame_id];
+  info.page_id_ = page_id;
+  Place(&info);
+  auto ghost = a1out_map_.find(page_id);
+  if (ghost != a1out_map_.end()) {
+    a1out_.erase(ghost->second);
+    a1out_map_.erase(ghost);
+    info.in_am_ = true;
+  } else {
+    a1in_size_++;
+  }
+}
@@ -0,0 +1,87 @@
+#include "common/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MINISQL_HAVE_SSE42_CRC
+#include <nmmintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t CRC32C_POLY = 0x82f63b78;  // reversed Castagnoli polynomial
+
+/**
+ * Slicing-by-8 tables, tables[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct Crc32cTables {
+  uint32_t tables_[8][256];
+
+  Crc32cTables() {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t crc = b;
+      for (int i = 0; i < 8; i++) {
+        crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+      }
+      tables_[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+      for (int k = 1; k < 8; k++) {
+        tables_[k][b] = (tables_[k - 1][b] >> 8) ^ tables_[0][tables_[k - 1][b] & 0xff];
+      }
+    }
+  }
+};
+
+const Crc32cTables crc32c_tables;
+
+#ifdef MINISQL_HAVE_SSE42_CRC
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(const void *data, size_t len) {
+  auto *p = static_cast<const unsigned char *>(data);
+  uint64_t crc = 0xffffffff;
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc);
+  for (; len > 0; p++, len--) {
+    crc32 = _mm_crc32_u8(crc32, *p);
+  }
+  return crc32 ^ 0xffffffff;
+}
+
+const bool crc32c_hardware = __builtin_cpu_supports("sse4.2");
+#else
+const bool crc32c_hardware = false;
+#endif
+
+}  // namespace
+
+uint32_t Crc32cSoftware(const void *data, size_t len) {
+  auto *p = static_cast<const unsigned char *>(data);
+  const auto &t = crc32c_tables.tables_;
+  uint32_t crc = 0xffffffff;
+  // 8 bytes at a time, assumes a little endian host like the rest of the storage layer
+  for (; len >= 8; p += 8, len -= 8) {
+    uint32_t low, high;
+    memcpy(&low, p, sizeof(low));
+    memcpy(&high, p + 4, sizeof(high));
+    low ^= crc;
+    crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+          t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+  }
+  for (; len > 0; p++, len--) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+  }
+  return crc ^ 0xffffffff;
+}
+
+uint32_t Crc32c(const void *data, size_t len) {
+#ifdef MINISQL_HAVE_SSE42_CRC
+  if (crc32c_hardware) return Crc32cHardware(data, len);
+#endif
+  return Crc32cSoftware(data, len);
+}
+
+bool Crc32cHardwareEnabled() { return crc32c_hardware; }
@@ -3,16 +3,35 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
-    : db_file_name_(std::move(db_name)), init_(init) {
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 const StorageOptions &options)
+    : db_file_name_(std::move(db_name)), init_(init), options_(options) {
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
   if (init_) {
-    remove(db_file_name_.c_str());
+    DiskManager::RemoveFiles(db_file_name_);
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, options.preallocate_extents_);
+  if (options.direct_io_) disk_mgr_->EnableDirectIO();
+  if (options.mmap_reads_) disk_mgr_->EnableMappedReads();
+  if (options.page_checksums_) disk_mgr_->EnableChecksums();
+  if (options.compress_pages_) disk_mgr_->EnableCompression();
+  if (options.scrub_interval_ms_ > 0) disk_mgr_->StartScrubber(std::chrono::milliseconds(options.scrub_interval_ms_));
+  if (options.budget_ == nullptr) {
+    bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, options.buffer_pool_instances_, options.replacer_type_);
+  } else {
+    // start small, the budget grows the pool to its share
+    size_t initial_size = std::min<size_t>(buffer_pool_size, MIN_BUFFER_POOL_SIZE);
+    bpm_ = new BufferPoolManager(initial_size, disk_mgr_, options.buffer_pool_instances_, options.replacer_type_,
+                                 buffer_pool_size);
+    options.budget_->Register(bpm_);
+  }
+  bpm_->SetPrefetchDepth(options.prefetch_depth_);
+  if (options.flush_interval_ms_ > 0) {
+    bpm_->StartBackgroundFlusher(std::chrono::milliseconds(options.flush_interval_ms_), options.flush_clean_ratio_);
+  }
+  if (!init_ && options.warm_up_) bpm_->StartWarmUp(db_file_name_ + ".warm");
 
   // Allocate static page for db storage engine
   if (init) {
@@ -43,6 +62,8 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
 
 DBStorageEngine::~DBStorageEngine() {
   delete catalog_mgr_;
+  if (options_.budget_ != nullptr) options_.budget_->Unregister(bpm_);
+  if (options_.warm_up_) bpm_->DumpResidentPages(db_file_name_ + ".warm");
   delete bpm_;
   delete disk_mgr_;
 }
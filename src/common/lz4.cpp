@@ -0,0 +1,143 @@
+#include "common/lz4.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr int MIN_MATCH = 4;
+constexpr int LAST_LITERALS = 5;  // the block must end with at least this many literals
+constexpr int MF_LIMIT = 12;      // no match may start within this many bytes of the end
+constexpr int MAX_OFFSET = 65535;
+constexpr int HASH_LOG = 12;
+
+inline uint32_t Read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_LOG); }
+
+/** Write the 255 run continuing a length whose nibble is full. */
+inline bool WriteLength(uint8_t *&op, const uint8_t *op_end, int length) {
+  for (; length >= 255; length -= 255) {
+    if (op >= op_end) return false;
+    *op++ = 255;
+  }
+  if (op >= op_end) return false;
+  *op++ = static_cast<uint8_t>(length);
+  return true;
+}
+
+/** Emit one sequence, match_length 0 stands for the literals closing the block. */
+bool WriteSequence(uint8_t *&op, const uint8_t *op_end, const uint8_t *literals, int literal_length, int offset,
+                   int match_length) {
+  if (op >= op_end) return false;
+  uint8_t *token = op++;
+  *token = static_cast<uint8_t>((literal_length >= 15 ? 15 : literal_length) << 4);
+  if (literal_length >= 15 && !WriteLength(op, op_end, literal_length - 15)) return false;
+  if (op_end - op < literal_length) return false;
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (match_length == 0) return true;
+  if (op_end - op < 2) return false;
+  *op++ = static_cast<uint8_t>(offset & 0xff);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  int length = match_length - MIN_MATCH;
+  *token |= static_cast<uint8_t>(length >= 15 ? 15 : length);
+  return length < 15 || WriteLength(op, op_end, length - 15);
+}
+
+/** Read the 255 run continuing a length whose nibble is full. */
+inline bool ReadLength(const uint8_t *&ip, const uint8_t *ip_end, int &length) {
+  uint8_t b;
+  do {
+    if (ip >= ip_end) return false;
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Greedy single pass matcher, a hash of the next four bytes points at the last position they were seen.
+ */
+int Lz4CompressBlock(const char *src, int src_size, char *dst, int dst_capacity) {
+  auto *base = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *ip = base, *anchor = base, *end = base + src_size;
+  auto *op = reinterpret_cast<uint8_t *>(dst);
+  const uint8_t *op_end = op + dst_capacity;
+  if (src_size > MAX_OFFSET + 1) return 0;
+  if (src_size >= MF_LIMIT + 1) {
+    int32_t table[1 << HASH_LOG];
+    memset(table, 0xff, sizeof(table));
+    const uint8_t *match_start_limit = end - MF_LIMIT;
+    const uint8_t *match_end_limit = end - LAST_LITERALS;
+    while (ip < match_start_limit) {
+      uint32_t sequence = Read32(ip);
+      uint32_t h = Hash(sequence);
+      int32_t candidate = table[h];
+      table[h] = static_cast<int32_t>(ip - base);
+      if (candidate < 0 || ip - (base + candidate) > MAX_OFFSET || Read32(base + candidate) != sequence) {
+        ip++;
+        continue;
+      }
+      const uint8_t *match = base + candidate;
+      int length = MIN_MATCH;
+      while (ip + length < match_end_limit && ip[length] == match[length]) {
+        length++;
+      }
+      if (!WriteSequence(op, op_end, anchor, static_cast<int>(ip - anchor), static_cast<int>(ip - match), length)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!WriteSequence(op, op_end, anchor, static_cast<int>(end - anchor), 0, 0)) return 0;
+  return static_cast<int>(op - reinterpret_cast<uint8_t *>(dst));
+}
+
+int Lz4DecompressBlock(const char *src, int src_size, char *dst, int dst_capacity) {
+  auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *ip_end = ip + src_size;
+  auto *base = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = base;
+  const uint8_t *op_end = base + dst_capacity;
+  while (ip < ip_end) {
+    uint8_t token = *ip++;
+    int literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(ip, ip_end, literal_length)) return -1;
+    if (ip_end - ip < literal_length || op_end - op < literal_length) return -1;
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == ip_end) break;  // the last sequence has no match
+    if (ip_end - ip < 2) return -1;
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op - base) return -1;
+    int match_length = token & 15;
+    if (match_length == 15 && !ReadLength(ip, ip_end, match_length)) return -1;
+    match_length += MIN_MATCH;
+    if (op_end - op < match_length) return -1;
+    // a match may overlap the bytes it produces, chunks of offset bytes never overlap their source
+    const uint8_t *match = op - offset;
+    if (offset == 1) {
+      memset(op, *match, match_length);
+    } else if (offset >= 8) {
+      for (int i = 0; i < match_length; i += offset) {
+        memcpy(op + i, match + i, match_length - i < offset ? match_length - i : offset);
+      }
+    } else {
+      for (int i = 0; i < match_length; i++) {
+        op[i] = match[i];
+      }
+    }
+    op += match_length;
+  }
+  return static_cast<int>(op - base);
+}
@@ -0,0 +1,39 @@
+#include "common/memory_arena.h"
+
+#include <cstring>
+
+void *MemoryArena::Allocate(size_t size, size_t align) {
+  bytes_allocated_ += size;
+  if (cursor_ != nullptr) {
+    char *aligned = Align(cursor_, align);
+    if (aligned + size <= end_) {
+      cursor_ = aligned + size;
+      return aligned;
+    }
+  }
+  if (size + align > block_size_ / 4) {
+    // a large allocation gets a block of its own, so the rest of the current block is not wasted
+    large_blocks_.emplace_back(new char[size + align]);
+    return Align(large_blocks_.back().get(), align);
+  }
+  blocks_.emplace_back(new char[block_size_]);
+  end_ = blocks_.back().get() + block_size_;
+  char *aligned = Align(blocks_.back().get(), align);
+  cursor_ = aligned + size;
+  return aligned;
+}
+
+char *MemoryArena::CopyBytes(const char *data, size_t len) {
+  auto copy = static_cast<char *>(Allocate(len, 1));
+  memcpy(copy, data, len);
+  return copy;
+}
+
+void MemoryArena::Reset() {
+  large_blocks_.clear();
+  bytes_allocated_ = 0;
+  if (blocks_.empty()) return;
+  blocks_.resize(1);
+  cursor_ = blocks_.front().get();
+  end_ = cursor_ + block_size_;
+}
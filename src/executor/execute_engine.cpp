@@ -5,6 +5,8 @@
 #include <sys/types.h>
 
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
@@ -15,6 +17,7 @@
 #include "executor/executors/values_executor.h"
 #include "glog/logging.h"
 #include "planner/planner.h"
+#include "record/csv_reader.h"
 #include "utils/utils.h"
 
 ExecuteEngine::ExecuteEngine() {
@@ -33,10 +36,19 @@ ExecuteEngine::ExecuteEngine() {
         strcmp( stdir->d_name , "..") == 0 ||
         stdir->d_name[0] == '.')
       continue;
-    dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    if (DiskManager::IsSideFile(stdir->d_name))
+      continue;
+    dbs_[stdir->d_name] = OpenDatabase(stdir->d_name, false);
   }
    **/
   closedir(dir);
+  budget_.StartPressureMonitor(std::chrono::milliseconds(DEFAULT_PRESSURE_INTERVAL_MS));
+}
+
+DBStorageEngine *ExecuteEngine::OpenDatabase(const std::string &db_name, bool init) {
+  StorageOptions options;
+  options.budget_ = &budget_;
+  return new DBStorageEngine(db_name, init, MAX_BUFFER_POOL_SIZE, options);
 }
 
 std::unique_ptr<AbstractExecutor> ExecuteEngine::CreateExecutor(ExecuteContext *exec_ctx,
@@ -83,10 +95,16 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
   try {
     executor->Init();
     RowId rid{};
-    Row row{};
+    // the rows kept in the result set are allocated from the arena of the query and moved rather than copied, the
+    // rows of a plan without a result set only live until the next one, in a scratch arena reset for every row
+    MemoryArena scratch;
+    Row row(result_set != nullptr ? exec_ctx->GetArena() : &scratch);
     while (executor->Next(&row, &rid)) {
       if (result_set != nullptr) {
-        result_set->push_back(row);
+        result_set->push_back(std::move(row));
+      } else {
+        row.destroy();
+        scratch.Reset();
       }
     }
   } catch (const exception &ex) {
@@ -133,6 +151,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteTrxCommit(ast, context.get());
     case kNodeTrxRollback:
       return ExecuteTrxRollback(ast, context.get());
+    case kNodeSet:
+      return ExecuteSet(ast, context.get());
+    case kNodeLoadData:
+      return ExecuteLoadData(ast, context.get());
     case kNodeExecFile:
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
@@ -247,7 +269,7 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
   if (dbs_.find(db_name) != dbs_.end()) {
     return DB_ALREADY_EXIST;
   }
-  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+  dbs_.insert(make_pair(db_name, OpenDatabase(db_name, true)));
   return DB_SUCCESS;
 }
 
@@ -259,9 +281,10 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   if (dbs_.find(db_name) == dbs_.end()) {
     return DB_NOT_EXIST;
   }
-  remove(("./databases/" + db_name).c_str());
+  // closing the engine writes its pages and side files, they are removed afterwards
   delete dbs_[db_name];
   dbs_.erase(db_name);
+  DiskManager::RemoveFiles("./databases/" + db_name);
   if (db_name == current_db_)
     current_db_ = "";
   return DB_SUCCESS;
@@ -408,6 +431,116 @@ dberr_t ExecuteEngine::ExecuteTrxRollback(pSyntaxNode ast, ExecuteContext *conte
   return DB_FAILED;
 }
 
+/**
+ * SET buffer_pool_budget = <megabytes> changes the memory the buffer pools of all open databases share. The value must
+ * be a whole number of megabytes, a negative, fractional or overflowing one is rejected.
+ */
+dberr_t ExecuteEngine::ExecuteSet(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSet" << std::endl;
+#endif
+  string variable = ast->child_->val_;
+  if (variable != "buffer_pool_budget") {
+    cout << "Unknown variable '" << variable << "'." << endl;
+    return DB_FAILED;
+  }
+  string value = ast->child_->next_->val_;
+  size_t frames;
+  if (!BufferPoolBudget::ParseMegabytes(value, &frames)) {
+    cout << "Invalid value '" << value << "' for buffer_pool_budget, expected a whole number of megabytes." << endl;
+    return DB_FAILED;
+  }
+  budget_.SetBudget(frames);
+  cout << "Buffer pool budget set to " << value << " MB, " << budget_.GetUsage() * PAGE_SIZE / (1024 * 1024)
+       << " MB in use." << endl;
+  return DB_SUCCESS;
+}
+
+/**
+ * COPY <table> FROM "<file>" and LOAD DATA INFILE "<file>" INTO TABLE <table> read a csv file in batches of
+ * BULK_LOAD_BATCH_SIZE rows, each batch is bulk inserted into the table heap and then added to the indexes. A row
+ * whose key is already in a unique index is dropped again, like an INSERT of it would fail. A malformed line ends the
+ * load with an error: the rows before it stay loaded, including those of its own batch, the lines after it are not read.
+ */
+dberr_t ExecuteEngine::ExecuteLoadData(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteLoadData" << std::endl;
+#endif
+  if (context == nullptr) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  auto start_time = std::chrono::system_clock::now();
+  string table_name = ast->child_->val_;
+  string file_name = ast->child_->next_->val_;
+  TableInfo *table_info = nullptr;
+  if (context->GetCatalog()->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  vector<IndexInfo *> indexes;
+  context->GetCatalog()->GetTableIndexes(table_name, indexes);
+  std::ifstream in(file_name);
+  if (!in.is_open()) {
+    cout << "Can not open file " << file_name << "." << endl;
+    return DB_FAILED;
+  }
+
+  CsvReader reader(in, table_info->GetSchema());
+  TableHeap *table_heap = table_info->GetTableHeap();
+  Txn *txn = context->GetTransaction();
+  size_t num_loaded = 0;
+  size_t num_duplicates = 0;
+  vector<Row> rows;
+  vector<RowId> rids;
+  rows.reserve(BULK_LOAD_BATCH_SIZE);
+  rids.reserve(BULK_LOAD_BATCH_SIZE);
+  while (reader.ReadRows(&rows, BULK_LOAD_BATCH_SIZE) > 0) {
+    bool inserted = table_heap->BulkInsert(rows.begin(), rows.end(), &rids, txn);
+    for (size_t i = 0; i < rids.size(); i++) {
+      // 逐个索引插入，遇到重复键就把已经插进去的撤回
+      size_t num_indexed = 0;
+      for (; num_indexed < indexes.size(); num_indexed++) {
+        auto info = indexes[num_indexed];
+        Row key_row;
+        rows[i].GetKeyFromRow(table_info->GetSchema(), info->GetIndexKeySchema(), key_row);
+        if (info->GetIndex()->InsertEntry(key_row, rids[i], txn) != DB_SUCCESS) break;
+      }
+      if (num_indexed == indexes.size()) {
+        num_loaded++;
+        continue;
+      }
+      for (size_t j = 0; j < num_indexed; j++) {
+        Row key_row;
+        rows[i].GetKeyFromRow(table_info->GetSchema(), indexes[j]->GetIndexKeySchema(), key_row);
+        indexes[j]->GetIndex()->RemoveEntry(key_row, rids[i], txn);
+      }
+      table_heap->ApplyDelete(rids[i], txn);
+      num_duplicates++;
+    }
+    rows.clear();
+    rids.clear();
+    if (!inserted) {
+      cout << "Failed to insert a row of " << file_name << "." << endl;
+      return DB_FAILED;
+    }
+  }
+  if (!reader.GetError().empty()) {
+    cout << "Malformed " << file_name << ", " << reader.GetError() << ", " << num_loaded << " rows before it loaded." << endl;
+    return DB_FAILED;
+  }
+  if (num_duplicates > 0) {
+    cout << num_duplicates << " rows skipped for duplicate keys." << endl;
+  }
+  auto stop_time = std::chrono::system_clock::now();
+  double duration_time =
+      double((std::chrono::duration_cast<std::chrono::milliseconds>(stop_time - start_time)).count());
+  std::stringstream ss;
+  ResultWriter writer(ss);
+  writer.EndInformation(num_loaded, duration_time, false);
+  std::cout << writer.stream_.rdbuf();
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -36,13 +36,12 @@ bool IndexScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *ou
 void IndexScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
                                       Row *output_row) {
   const auto &output_columns = output_schema->GetColumns();
-  std::vector<Field> dest_row;
-  dest_row.reserve(output_columns.size());
+  output_row->destroy();
+  output_row->SetRowId(row->GetRowId());
+  output_row->GetFields().reserve(output_columns.size());
   for (const auto column : output_columns) {
-    auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
+    output_row->AppendField(*row->GetField(column->GetTableInd()));
   }
-  *output_row = Row(dest_row);
 }
 
 vector<RowId> IndexScanExecutor::IndexScan(AbstractExpressionRef predicate) {
@@ -87,22 +86,23 @@ bool IndexScanExecutor::Next(Row *row, RowId *rid) {
   auto predicate = plan_->GetPredicate();
   auto table_schema = table_info_->GetSchema();
   while (cursor_ < result_.size()) {
-    auto p_row = new Row(result_[cursor_]);
-    table_info_->GetTableHeap()->GetTuple(p_row, nullptr);
+    // every tuple examined is read into the scratch arena, only the one produced is copied into row
+    scratch_.Reset();
+    Row tuple(&scratch_);
+    tuple.SetRowId(result_[cursor_]);
+    table_info_->GetTableHeap()->GetTuple(&tuple, nullptr);
     if (plan_->need_filter_) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
+      if (!predicate->Evaluate(&tuple).CompareEquals(Field(kTypeInt, 1))) {
         cursor_++;
-        delete p_row;
         continue;
       }
     }
     *rid = result_[cursor_];
     if (!is_schema_same_) {
-      TupleTransfer(table_schema, plan_->OutputSchema(), p_row, row);
+      TupleTransfer(table_schema, plan_->OutputSchema(), &tuple, row);
     } else {
-      *row = *p_row;
+      *row = tuple;
     }
-    delete p_row;
     cursor_++;
     return true;
   }
@@ -26,45 +26,39 @@ bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *outp
   return true;
 }
 
-void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
-                                    Row *output_row) {
-  const auto &output_columns = output_schema->GetColumns();
-  std::vector<Field> dest_row;
-  dest_row.reserve(output_columns.size());
-  for (const auto column : output_columns) {
-    auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
-  }
-  *output_row = Row(dest_row);
-}
-
 void SeqScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  columns_.clear();
+  if (is_schema_same_) {
+    for (uint32_t i = 0; i < schema_->GetColumnCount(); i++) {
+      columns_.push_back(i);
+    }
+  } else {
+    for (const auto column : schema_->GetColumns()) {
+      columns_.push_back(column->GetTableInd());
+    }
+  }
+  TableIterator::RowFilter filter = nullptr;
+  auto predicate = plan_->GetPredicate();
+  if (predicate != nullptr) {
+    // a null result is let through, as when the predicate was evaluated on a deserialized row
+    filter = [predicate](const RowView &view) {
+      return predicate->Evaluate(view).CompareEquals(Field(kTypeInt, 1)) != kFalse;
+    };
+  }
+  // a scan only recycles a small ring of frames, so it does not flush the working set of the buffer pool
+  iterator_ = table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction(), std::make_shared<BufferAccessStrategy>(),
+                                                 std::move(filter));
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
-  auto predicate = plan_->GetPredicate();
-  auto table_schema = table_info_->GetSchema();
-  while (iterator_ != table_info_->GetTableHeap()->End()) {
-    auto p_row = &(*iterator_);
-    if (predicate != nullptr) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        iterator_++;
-        continue;
-      }
-    }
-    *rid = iterator_->GetRowId();
-    if (!is_schema_same_) {
-      TupleTransfer(table_schema, schema_, p_row, row);
-    } else {
-      *row = *p_row;
-    }
-    iterator_++;
-    return true;
+  if (iterator_ == table_info_->GetTableHeap()->End()) {
+    return false;
   }
-  return false;
+  *rid = iterator_.GetRowId();
+  iterator_.Materialize(columns_, row);
+  ++iterator_;
+  return true;
 }
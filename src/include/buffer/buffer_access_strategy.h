@@ -0,0 +1,39 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * A small ring of frames recycled by one bulk reader (a sequential scan).
+ *
+ * Only frames the reader had to load from disk enter the ring. Once the ring is full, the next miss reuses its oldest
+ * frame instead of asking the replacer for a victim, as long as nobody else has the page pinned. Pages touched only
+ * by the scan therefore never displace the working set of the shared buffer pool.
+ */
+struct BufferRing {
+  size_t capacity_{0};
+  std::deque<std::pair<frame_id_t, page_id_t>> frames_;  // oldest first
+};
+
+/**
+ * BufferAccessStrategy is handed to BufferPoolManager::FetchPage by bulk readers. It owns one BufferRing per buffer
+ * pool instance, so that a recycled frame always belongs to the instance the new page is routed to.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  explicit BufferAccessStrategy(size_t ring_size = DEFAULT_SCAN_RING_SIZE) : ring_size_(ring_size) {}
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  size_t ring_size_;
+  std::vector<BufferRing> rings_;  // sized by the buffer pool on first use
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
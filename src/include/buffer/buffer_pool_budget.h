@@ -0,0 +1,88 @@
+#ifndef MINISQL_BUFFER_POOL_BUDGET_H
+#define MINISQL_BUFFER_POOL_BUDGET_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * BufferPoolBudget caps the frames of a set of buffer pools, typically those of all the databases one ExecuteEngine
+ * has open. Every time a pool joins or leaves or the budget changes, the budget is split evenly between the pools and
+ * each pool is resized online to its share. A pool never gets more than its GetMaxPoolSize(), whatever it cannot use is
+ * split among the others, and never less than MIN_BUFFER_POOL_SIZE.
+ *
+ * Pools are shrunk before others grow, so that the total stays within the budget as far as possible. A pool whose
+ * frames are pinned may not shrink all the way, the total then stays above the budget until the next rebalance.
+ *
+ * The budget also gives way to memory pressure: on Linux the pools never take more than the memory the kernel reports
+ * as available, less a reserve left to the rest of the system, and they shrink below the budget when the available
+ * memory falls under the reserve. StartPressureMonitor checks for pressure periodically, in between the pools only
+ * react to it when they are rebalanced.
+ */
+class BufferPoolBudget {
+ public:
+  /** @param reserve frames of memory to leave available to the rest of the system */
+  explicit BufferPoolBudget(size_t budget = DEFAULT_BUFFER_POOL_BUDGET, size_t reserve = DEFAULT_MEMORY_RESERVE)
+      : budget_(budget), reserve_(reserve) {}
+
+  /** Stops the pressure monitor. */
+  ~BufferPoolBudget();
+
+  /** Add a pool, the others shrink to make room for it. */
+  void Register(BufferPoolManager *bpm);
+
+  /** Remove a pool, which keeps its current size, the others grow into its share. */
+  void Unregister(BufferPoolManager *bpm);
+
+  /** Change the budget, in frames, and resize the pools to their new share. */
+  void SetBudget(size_t budget);
+
+  inline size_t GetBudget() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return budget_;
+  }
+
+  /** Change the reserve, in frames, and resize the pools to their new share. */
+  void SetMemoryReserve(size_t reserve);
+
+  /** @return number of frames in use over all the pools */
+  size_t GetUsage();
+
+  /** Start a background thread which rebalances the pools every interval, so that they follow memory pressure. */
+  void StartPressureMonitor(std::chrono::milliseconds interval);
+
+  /** Stop the pressure monitor and wait for it to finish. */
+  void StopPressureMonitor();
+
+  /**
+   * Convert a budget given in megabytes, as in SET buffer_pool_budget, into frames.
+   * @return false if value is not a whole, non-negative number of megabytes or is too large to count in bytes
+   */
+  static bool ParseMegabytes(const std::string &value, size_t *frames);
+
+ private:
+  /** Resize every pool to its share, latch_ must be held. */
+  void Rebalance();
+
+  void MonitorPressure(std::chrono::milliseconds interval);
+
+  /** @return frames of memory the kernel reports as available, SIZE_MAX if it does not tell */
+  static size_t GetAvailableFrames();
+
+ private:
+  std::mutex latch_;
+  size_t budget_;
+  size_t reserve_;
+  std::vector<BufferPoolManager *> pools_;
+  std::thread monitor_;                    // see StartPressureMonitor
+  std::mutex monitor_latch_;               // protects stop_monitor_
+  std::condition_variable monitor_cv_;     // wakes the monitor up early on shutdown
+  bool stop_monitor_{false};
+};
+
+#endif  // MINISQL_BUFFER_POOL_BUDGET_H
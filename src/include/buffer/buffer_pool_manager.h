@@ -1,25 +1,74 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/page_guard.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/** @return id of the page following page in its chain, INVALID_PAGE_ID at the end of the chain */
+using NextPageIdFn = page_id_t (*)(Page *page);
+
+/**
+ * BufferPoolManager splits its frames into `num_instances` independent BufferPoolManagerInstance shards and routes
+ * every page to the shard `page_id % num_instances`. With a single instance it behaves like a plain buffer pool.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  /** @param max_pool_size frames the pool can grow to with Resize, 0 for pool_size */
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             size_t num_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                             ReplacerType replacer_type = ReplacerType::kLRU, size_t max_pool_size = 0);
 
   ~BufferPoolManager();
 
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch a page on behalf of a bulk reader, pages it loads are recycled through the rings of strategy.
+   * A null strategy is a plain FetchPage.
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Fetch a page which the caller only reads. If the disk manager maps the db file, a page which is not cached yet is
+   * read in place from the mapping rather than copied into a frame. Writing to the page is not allowed.
+   */
+  Page *FetchPageForRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Fetch a page pinned by the returned guard, which is empty if the page cannot be brought into the pool.
+   * A guard from FetchPageGuardedForRead must not be used to write to the page, see FetchPageForRead.
+   */
+  PageGuard FetchPageGuarded(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  PageGuard FetchPageGuardedForRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /** Fetch a page which is only read, pinned and read latched by the returned guard. */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /**
+   * Fetch a page pinned and write latched by the returned guard. The guard unpins it dirty once the page has been
+   * accessed through GetPage, GetData or As, clean otherwise.
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /** Allocate a page like NewPage, pinned by the returned guard, which always unpins it dirty. */
+  PageGuard NewPageGuarded(page_id_t &page_id);
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
@@ -32,6 +81,84 @@ class BufferPoolManager {
 
   bool CheckAllUnpinned();
 
+  /**
+   * Ask the prefetcher to read page_id into the pool in the background. Pages which are free on disk are skipped.
+   */
+  void PrefetchPage(page_id_t page_id);
+
+  /**
+   * Ask the prefetcher to read count pages with consecutive ids starting at first_page_id, stopping at the first page
+   * which is free on disk.
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t count);
+
+  /**
+   * Ask the prefetcher to read up to GetPrefetchDepth() pages of the chain starting at page_id, next_page_id tells it
+   * how to follow the chain. Does nothing if the prefetch depth is 0.
+   */
+  void PrefetchChain(page_id_t page_id, NextPageIdFn next_page_id);
+
+  /** Set how many pages ahead iterators keep in flight, 0 disables read-ahead. */
+  inline void SetPrefetchDepth(size_t depth) { prefetch_depth_ = depth; }
+
+  inline size_t GetPrefetchDepth() const { return prefetch_depth_; }
+
+  /**
+   * Start a background thread which every interval writes back dirty, unpinned pages until at least clean_ratio of
+   * the frames of each instance are clean. Does nothing if the flusher is already running.
+   */
+  void StartBackgroundFlusher(std::chrono::milliseconds interval, double clean_ratio = DEFAULT_FLUSH_CLEAN_RATIO);
+
+  /** Stop the background flusher and wait for it to finish its current round. */
+  void StopBackgroundFlusher();
+
+  /**
+   * Write the ids of the cached pages to path, hottest first by the priority of the replacers, so that the pool of a
+   * later open can be warmed up with StartWarmUp.
+   * @return number of page ids written
+   */
+  size_t DumpResidentPages(const std::string &path);
+
+  /**
+   * Start a background thread which reads back the pages listed in path by DumpResidentPages while the pool is already
+   * serving requests. Only the hottest pages fitting in the pool are read, in page id order, which is also their order
+   * in the db file, pages freed since the dump are skipped. The file is removed once read, so a dump is used only once.
+   * Does nothing if path does not exist or a warm-up is already running.
+   *
+   * Queries race the warm-up for the same pages, it only gets ahead of them when it has a core of its own and the reads
+   * wait for the disk. On a single core, or when the db file is in the page cache, the queries load the hot pages as
+   * fast as the warm-up would, call WaitForWarmUp before serving them to start with a warm pool.
+   */
+  void StartWarmUp(const std::string &path);
+
+  /** Block until the warm-up thread, if any, has read all its pages. */
+  void WaitForWarmUp();
+
+  /** @return number of pages read by warm-ups since the pool was created */
+  inline size_t GetWarmUpCount() const { return num_warm_up_pages_; }
+
+  /**
+   * Grow or shrink the pool to pool_size frames online, spread over the instances like at construction, see
+   * BufferPoolManagerInstance::Resize. The pool never shrinks below one frame per instance nor grows beyond
+   * GetMaxPoolSize().
+   * @return the number of frames in use afterwards, more than pool_size if pinned frames kept a shrink from finishing
+   */
+  size_t Resize(size_t pool_size);
+
+  /** @return total number of frames in use over all instances */
+  inline size_t GetPoolSize() const { return pool_size_.load(std::memory_order_relaxed); }
+
+  /** @return total number of frames the instances can grow to */
+  inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return number of FetchPage calls served from memory since the pool was created */
+  uint64_t GetHitCount();
+
+  /** @return number of FetchPage calls which had to read the disk since the pool was created */
+  uint64_t GetMissCount();
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
@@ -43,16 +170,59 @@ class BufferPoolManager {
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /** @return index of the instance responsible for page_id */
+  inline size_t GetInstanceIndex(page_id_t page_id) const { return static_cast<size_t>(page_id) % instances_.size(); }
+
+  /** @return the instance responsible for page_id */
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) { return instances_[GetInstanceIndex(page_id)]; }
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy, bool read_only);
+
+  void BackgroundFlush(std::chrono::milliseconds interval, double clean_ratio);
+
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;
+    NextPageIdFn next_page_id_;  // null for consecutive page ids
+  };
+
+  void EnqueuePrefetch(const PrefetchRequest &request);
+
+  void PrefetchWorker();
+
+  void RunPrefetch(const PrefetchRequest &request, AsyncIO *aio);
+
+  void StopPrefetcher();
+
+  /** Block until the prefetcher has nothing queued or running. */
+  void WaitForPrefetches();
+
+  void WarmUp(std::vector<page_id_t> pages);
+
+  static constexpr size_t MAX_PENDING_PREFETCHES = 64;  // older requests are dropped beyond this
+  static constexpr uint32_t WARM_UP_MAGIC = 0x5755534d;  // "MSUW", first word of a dump of the resident pages
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  std::atomic<size_t> pool_size_;                       // number of frames in use
+  size_t max_pool_size_;                                // number of frames the pool can grow to
+  std::mutex resize_latch_;                             // serializes Resize
+  DiskManager *disk_manager_;                           // pointer to the disk manager.
+  std::vector<BufferPoolManagerInstance *> instances_;  // shards, each with its own latch
+  std::thread flusher_;                                 // background writer, see StartBackgroundFlusher
+  std::mutex flusher_latch_;                            // protects stop_flusher_
+  std::condition_variable flusher_cv_;                  // wakes the flusher up early on shutdown
+  bool stop_flusher_{false};
+  size_t prefetch_depth_{0};                            // pages iterators keep in flight
+  std::thread prefetcher_;                              // started by the first prefetch request
+  std::mutex prefetch_latch_;                           // protects the fields below
+  std::condition_variable prefetch_cv_;                 // wakes the prefetcher up
+  std::condition_variable prefetch_idle_cv_;            // signalled when a request is done
+  std::deque<PrefetchRequest> prefetch_queue_;
+  bool prefetch_busy_{false};
+  bool stop_prefetcher_{false};
+  std::thread warmer_;                                  // started by StartWarmUp
+  std::atomic<bool> stop_warm_up_{false};
+  std::atomic<size_t> num_warm_up_pages_{0};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -0,0 +1,208 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/frame_arena.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
+#include "page/page.h"
+#include "storage/async_io.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/**
+ * BufferPoolManagerInstance is one shard of the buffer pool. It owns its own frames, page table, free list, replacer
+ * and latch, so that pages routed to different instances never contend with each other.
+ *
+ * Page ids are allocated by the owning BufferPoolManager, an instance only caches the pages routed to it.
+ *
+ * A hit takes no latch: the page is looked up in a lock-free PageTable and pinned with an atomic increment, an unpin is
+ * an atomic decrement. Loading, evicting or freeing a frame happens under the latch, after claiming the frame by
+ * swapping its pin count from 0 to CLAIMED_PIN_COUNT, which a lock-free pin backs off from. Hits are not reported to
+ * the replacer one by one, a hit sets the reference bit of its frame and queues the frame once, and the queued
+ * references are handed to the replacer under the latch before it picks a victim. A frame stays in the replacer while
+ * it is pinned by hits, a victim which turns out to be pinned leaves the replacer and comes back when it is unpinned.
+ *
+ * The instance is created for up to max_pool_size frames, of which pool_size are in use, see Resize. Address space is
+ * reserved for all of them up front so that a Page never moves, only the frames in use are backed by memory.
+ */
+class BufferPoolManagerInstance {
+ public:
+  /** @param max_pool_size frames the instance can grow to with Resize, 0 for pool_size */
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = ReplacerType::kLRU, size_t max_pool_size = 0);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * Fetch a page, a miss reuses the oldest frame of ring when possible instead of evicting through the replacer.
+   * @param read_only if the db file is mapped, the page may be read in place instead of being copied into the frame
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr, bool read_only = false);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Bring a page which has just been allocated on disk into this instance.
+   * @return nullptr if all the frames of this instance are pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Bring a page in ahead of its use. Unlike FetchPage this does not count as a hit or a miss. If the page is not
+   * cached yet a frame is claimed for it and *loading is set, the caller must then read the page into it without
+   * holding any latch and call FinishPrefetch.
+   * @param read_ahead whether the page is read ahead of a scan, the first fetch of such a page through a ring adopts it
+   * into the ring
+   * @return the page pinned, or nullptr if all the frames of this instance are pinned
+   */
+  Page *StartPrefetch(page_id_t page_id, bool *loading, bool read_ahead = true);
+
+  /** Publish a page read after StartPrefetch and drop its pin, a failed read drops the page. */
+  void FinishPrefetch(Page *page, bool ok);
+
+  /**
+   * Write back the dirty, unpinned pages nearest to eviction, in ascending page id order, until at least clean_ratio of
+   * the frames hold clean pages. The latch is not held while the pages are written.
+   * @param aio if given, the writes of a batch are all in flight at the same time
+   * @return number of pages written back
+   */
+  size_t FlushDirtyPages(double clean_ratio, AsyncIO *aio = nullptr);
+
+  /**
+   * @return the pages cached by this instance, hottest first: the pinned pages, then the others in the reverse of the
+   * order the replacer would evict them
+   */
+  std::vector<page_id_t> GetResidentPages();
+
+  bool CheckAllUnpinned();
+
+  /**
+   * Grow or shrink the instance to pool_size frames, at least 1 and at most GetMaxPoolSize(), while it keeps serving
+   * requests. Growing hands out new free frames. Shrinking takes free frames first, then evicts victims of the replacer,
+   * writing them back if they are dirty, and gives their memory back to the kernel. Pinned frames cannot be taken, so
+   * a shrink may stop short of pool_size.
+   * @return the number of frames in use afterwards
+   */
+  size_t Resize(size_t pool_size);
+
+  /** @return number of frames in use */
+  inline size_t GetPoolSize() const { return pool_size_.load(std::memory_order_relaxed); }
+
+  /** @return number of frames the instance can grow to */
+  inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  /** @return number of FetchPage calls served without reading the disk */
+  uint64_t GetHitCount() const;
+
+  /** @return number of FetchPage calls which had to read the disk */
+  inline uint64_t GetMissCount() const { return num_misses_.load(std::memory_order_relaxed); }
+
+ private:
+  /** Per frame state read and written without the latch. */
+  struct FrameState {
+    std::atomic<bool> prefetched_{false};  // loaded by PrefetchPage and not fetched since
+    std::atomic<bool> referenced_{false};  // hit since the replacer was last told
+    std::atomic<bool> tracked_{false};     // the replacer holds the frame
+  };
+
+  static constexpr size_t REFERENCE_QUEUE_SIZE = 256;  // hits queued per stripe between two misses, older ones dropped
+  static constexpr size_t NUM_HIT_STRIPES = 8;
+
+  /**
+   * Hits of the threads mapped to one stripe. Every stripe sits on cache lines of its own, so that hits served by
+   * different threads without the latch do not all write the same counter and queue index.
+   */
+  struct alignas(CACHE_LINE_SIZE) HitStripe {
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint32_t> next_reference_{0};
+    std::atomic<frame_id_t> references_[REFERENCE_QUEUE_SIZE];  // frames hit since the last miss
+  };
+
+  static Replacer *CreateReplacer(ReplacerType replacer_type, size_t pool_size);
+
+  /** @return a claimed frame from the free list or the replacer, INVALID_FRAME_ID if all frames are pinned */
+  frame_id_t TryToFindFreePage();
+
+  /** @return a claimed frame of ring which can be recycled, INVALID_FRAME_ID if none */
+  frame_id_t TryToRecycleRingFrame(BufferRing *ring);
+
+  void AdoptIntoRing(BufferRing *ring, frame_id_t frame_id, page_id_t page_id);
+
+  /** Block until no prefetch is reading page_id, lock must hold latch_. */
+  void WaitForLoad(std::unique_lock<std::mutex> &lock, page_id_t page_id);
+
+  /** Pin frame_id without the latch, provided it holds page_id and is not claimed. */
+  bool TryPin(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Drop one pin of frame_id.
+   * @return whether that was the last pin of a frame the replacer does not hold, see TrackIfIdle
+   */
+  bool DropPin(frame_id_t frame_id);
+
+  /** Give an unpinned frame which holds a page back to the replacer, latch_ must be held. */
+  void TrackIfIdle(frame_id_t frame_id);
+
+  /** Take a frame out of the replacer, latch_ must be held. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @return whether the frame was unpinned and is now claimed */
+  inline bool Claim(frame_id_t frame_id) {
+    int expected = 0;
+    return pages_[frame_id].pin_count_.compare_exchange_strong(expected, CLAIMED_PIN_COUNT);
+  }
+
+  /** End the claim of a frame, leaving it with pin_count pins. */
+  inline void Publish(frame_id_t frame_id, int pin_count) {
+    pages_[frame_id].pin_count_.fetch_add(pin_count - CLAIMED_PIN_COUNT);
+  }
+
+  /** Count a hit on frame_id and queue it for the replacer, unless one is already queued. */
+  void RecordHit(frame_id_t frame_id);
+
+  /** Hand the queued hits to the replacer, latch_ must be held. */
+  void ApplyReferences();
+
+  /** The part of a hit which needs the latch, the page is pinned already. */
+  void FinishHit(frame_id_t frame_id, BufferRing *ring, bool read_only);
+
+  /** @return the hit stripe of the calling thread */
+  HitStripe &ThisThreadStripe();
+
+  static constexpr int CLAIMED_PIN_COUNT = INT_MIN / 2;  // stays negative whatever the number of pins backing off
+
+ private:
+  std::atomic<size_t> pool_size_;                    // number of frames in use, changed under latch_ only
+  size_t max_pool_size_;                             // number of frames reserved
+  size_t num_frames_{0};                             // frames whose Page has been built, in use or retired
+  FrameArena arena_;                                 // data of the pages, one PAGE_SIZE aligned slot per frame
+  Page *pages_;                                      // metadata of the pages, data_ pointing into arena_
+  vector<frame_id_t> retired_;                       // frames given up by Resize, kept claimed so no hit pins them
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  PageTable page_table_;                             // to keep track of pages, changed under latch_ only
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  mutex latch_;                                      // to protect shared data structure
+  std::unique_ptr<FrameState[]> frames_;             // indexed like pages_
+  std::unique_ptr<HitStripe[]> stripes_;             // hits served without the latch, NUM_HIT_STRIPES of them
+  unordered_set<page_id_t> loading_;                 // pages read or written outside the latch, by prefetch or flush
+  condition_variable loading_cv_;                    // signalled whenever a page leaves loading_
+  std::atomic<uint64_t> num_misses_{0};              // FetchPage statistics, the hits are counted per stripe
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
@@ -41,6 +41,8 @@ class CLOCKReplacer : public Replacer {
 
   std::size_t Size() override;
 
+  std::vector<frame_id_t> GetVictimOrder() override;
+
  private:
   std::size_t capacity;
   list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
@@ -0,0 +1,46 @@
+#ifndef MINISQL_FRAME_ARENA_H
+#define MINISQL_FRAME_ARENA_H
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * FrameArena is the memory the data of the frames of a buffer pool instance lives in: one anonymous mapping, zeroed by
+ * the kernel and only backed by memory once touched, carved into PAGE_SIZE aligned frames. Keeping the data apart from
+ * the Page objects packs the frame metadata densely and lets the data be read with O_DIRECT.
+ *
+ * With huge_pages the mapping is aligned to HUGE_PAGE_SIZE and the kernel is asked to back it with transparent huge
+ * pages, so a large pool costs a few TLB entries instead of one per frame. That is only advice, the arena works the same
+ * if the kernel does not follow it.
+ */
+class FrameArena {
+ public:
+  explicit FrameArena(size_t num_frames, bool huge_pages = BUFFER_POOL_HUGE_PAGES);
+
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /** @return the PAGE_SIZE bytes of data of a frame */
+  inline char *GetFrame(frame_id_t frame_id) const { return base_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  inline size_t GetNumFrames() const { return num_frames_; }
+
+  /** Hand the memory of a frame back to the kernel, the frame reads as zeros afterwards. */
+  void Release(frame_id_t frame_id);
+
+  /** @return whether the kernel accepted the advice to use huge pages for the arena */
+  inline bool IsHugePageBacked() const { return huge_pages_; }
+
+ private:
+  size_t num_frames_;
+  char *region_{nullptr};  // the whole mapping, base_ rounded down to its start
+  size_t region_size_{0};
+  char *base_{nullptr};  // frame 0
+  bool huge_pages_{false};
+};
+
+#endif  // MINISQL_FRAME_ARENA_H
@@ -0,0 +1,70 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <list>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame whose K-th most recent reference is the oldest. Frames referenced fewer than K
+ * times have an infinite backward K-distance and are evicted first, oldest first reference first, so pages touched
+ * once by a sequential scan never push out pages that are referenced repeatedly (index internals, catalog pages).
+ *
+ * Consecutive references to the same frame (no other frame referenced in between, e.g. the iterator and GetTuple
+ * fetching the same heap page for every tuple) are correlated and count as a single reference.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references kept for every frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  std::vector<frame_id_t> GetVictimOrder() override;
+
+  void SetPage(frame_id_t frame_id, page_id_t page_id) override;
+
+ private:
+  /** (has K references, timestamp) ordered so that the first element of the set is the victim */
+  using EvictKey = std::pair<bool, uint64_t>;
+
+  struct FrameHistory {
+    std::list<uint64_t> refs_;  // most recent first, at most k_ entries
+    bool evictable_{false};
+  };
+
+  EvictKey KeyOf(const FrameHistory &history) const;
+
+ private:
+  size_t max_capacity_;
+  size_t k_;
+  uint64_t current_ts_{0};
+  frame_id_t last_frame_{INVALID_FRAME_ID};
+  std::unordered_map<frame_id_t, FrameHistory> histories_;
+  std::set<std::pair<EvictKey, frame_id_t>> evictable_;
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -36,6 +36,8 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  std::vector<frame_id_t> GetVictimOrder() override;
+
 private:
   // 用链表+哈希表实现
   size_t max_capacity;
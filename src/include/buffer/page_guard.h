@@ -0,0 +1,139 @@
+#ifndef MINISQL_PAGE_GUARD_H
+#define MINISQL_PAGE_GUARD_H
+
+#include "common/config.h"
+#include "page/page.h"
+
+class BufferPoolManager;
+
+/**
+ * PageGuard owns one pin of a page and drops it, dirty if the guard was marked so, when it is destroyed or dropped.
+ * It is move-only, moving a guard hands the pin over and leaves the source empty.
+ */
+class PageGuard {
+ public:
+  PageGuard() = default;
+
+  /** Take over a pin already held on page, a null page makes an empty guard. */
+  PageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  PageGuard(PageGuard &&that) noexcept;
+
+  PageGuard &operator=(PageGuard &&that) noexcept;
+
+  PageGuard(const PageGuard &) = delete;
+
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  ~PageGuard() { Drop(); }
+
+  /** Unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  /** @return false for an empty guard, e.g. when the page could not be brought into the pool */
+  inline bool IsValid() const { return page_ != nullptr; }
+
+  inline page_id_t GetPageId() const { return page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId(); }
+
+  inline Page *GetPage() const { return page_; }
+
+  inline char *GetData() const { return page_->GetData(); }
+
+  /** @return the data of the page viewed as a T, for pages like the B+ tree pages which overlay it */
+  template <typename T>
+  inline T *As() const {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+  /** Have the page unpinned dirty. */
+  inline void MarkDirty() { is_dirty_ = true; }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds a pin and the read latch of a page, both are released when the guard is destroyed or dropped.
+ * The page may be read in place from the mapped db file, so it must not be written to. Its data is handed out const,
+ * the Page itself is not since page types like TablePage only have non-const readers.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** Take over a pin already held on page and read latch it. */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page);
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline page_id_t GetPageId() const { return guard_.GetPageId(); }
+
+  inline Page *GetPage() const { return guard_.GetPage(); }
+
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  template <typename T>
+  inline const T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  PageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds a pin and the write latch of a page. Any access to the page through the guard marks it dirty,
+ * the page is unpinned dirty once the guard is destroyed or dropped.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** Take over a pin already held on page and write latch it. */
+  WritePageGuard(BufferPoolManager *bpm, Page *page);
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline page_id_t GetPageId() const { return guard_.GetPageId(); }
+
+  inline Page *GetPage() {
+    guard_.MarkDirty();
+    return guard_.GetPage();
+  }
+
+  inline char *GetData() {
+    guard_.MarkDirty();
+    return guard_.GetData();
+  }
+
+  template <typename T>
+  inline T *As() {
+    guard_.MarkDirty();
+    return guard_.As<T>();
+  }
+
+ private:
+  PageGuard guard_;
+};
+
+#endif  // MINISQL_PAGE_GUARD_H
@@ -0,0 +1,57 @@
+#ifndef MINISQL_PAGE_TABLE_H
+#define MINISQL_PAGE_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+/**
+ * PageTable maps the page ids cached by a buffer pool instance to their frames. It is an open addressing table with
+ * linear probing, sized once for the number of frames, whose slots each hold a page id and its frame in one atomic
+ * word.
+ *
+ * Insert and Erase must be serialized by the caller, Find may run at any time without a latch. A Find racing with
+ * Erase may miss a page which is cached, or return a frame which has just been given to another page, so a lock-free
+ * reader must check the frame it gets and fall back to a locked lookup when it gets nothing.
+ */
+class PageTable {
+ public:
+  explicit PageTable(size_t num_frames);
+
+  /** @return the frame holding page_id, INVALID_FRAME_ID if none */
+  frame_id_t Find(page_id_t page_id) const;
+
+  /** Map page_id, which must not be in the table yet, to frame_id. */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /** @return false if page_id was not in the table */
+  bool Erase(page_id_t page_id);
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = ~0ULL;
+
+  static inline uint64_t MakeSlot(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+
+  static inline page_id_t SlotPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+
+  static inline frame_id_t SlotFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xFFFFFFFFULL); }
+
+  /** @return the slot probing for page_id starts at */
+  inline size_t Home(page_id_t page_id) const {
+    // Fibonacci hashing, consecutive page ids land far apart
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+ private:
+  size_t capacity_;  // a power of two, at least twice the number of frames
+  size_t mask_;
+  int shift_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+#endif  // MINISQL_PAGE_TABLE_H
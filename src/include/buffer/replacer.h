@@ -2,9 +2,15 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
+/**
+ * Replacement policies the buffer pool can be built with.
+ */
+enum class ReplacerType { kLRU, kCLOCK, kLRUK, k2Q };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -35,6 +41,27 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual std::size_t Size() = 0;
+
+  /**
+   * Lists the frames which can be victimized without removing them.
+   * @return the frames in the order Victim would hand them out, the next victim first
+   */
+  virtual std::vector<frame_id_t> GetVictimOrder() = 0;
+
+  /**
+   * Tells the replacer that a frame now holds a different page. Policies keeping history across evictions use it,
+   * the others can ignore it.
+   * @param frame_id the id of the frame the page was loaded into
+   * @param page_id the id of the page now held by the frame
+   */
+  virtual void SetPage([[maybe_unused]] frame_id_t frame_id, [[maybe_unused]] page_id_t page_id) {}
+
+  /**
+   * Tells the replacer that the buffer pool now uses num_pages frames, after growing or shrinking online. Frame ids
+   * stay below the number of pages the replacer was created with. Policies sized after the pool use it, the others can
+   * ignore it.
+   */
+  virtual void Resize([[maybe_unused]] size_t num_pages) {}
 };
 
 #endif  // MINISQL_REPLACER_H
@@ -0,0 +1,81 @@
+#ifndef MINISQL_TWO_QUEUE_REPLACER_H
+#define MINISQL_TWO_QUEUE_REPLACER_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+using namespace std;
+
+/**
+ * TwoQueueReplacer implements the full 2Q replacement policy (Johnson & Shasha).
+ *
+ * - A1in: FIFO of pages seen for the first time. Re-references while in A1in are treated as correlated and ignored.
+ * - A1out: ghost FIFO remembering the page ids recently evicted from A1in, it holds no frame.
+ * - Am: LRU of pages referenced again after leaving A1in, i.e. the hot set.
+ *
+ * A sequential scan only cycles through A1in, pages only reach Am when they come back after having been evicted.
+ *
+ * The queues only hold evictable frames, keyed by the sequence number of the reference which placed the frame, so a
+ * frame pinned and unpinned again goes back to its place and Victim takes the head of a queue without scanning.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  /**
+   * Create a new TwoQueueReplacer.
+   * @param num_pages the maximum number of pages the TwoQueueReplacer will be required to store
+   */
+  explicit TwoQueueReplacer(size_t num_pages);
+
+  ~TwoQueueReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  std::vector<frame_id_t> GetVictimOrder() override;
+
+  void SetPage(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Resize(size_t num_pages) override;
+
+ private:
+  struct FrameInfo {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool in_am_{false};
+    bool evictable_{false};
+    uint64_t seq_{0};  // position in its queue
+  };
+
+  void Remove(frame_id_t frame_id);
+
+  /** Start a new position for frame in its queue. */
+  void Place(FrameInfo *info);
+
+  inline std::map<uint64_t, frame_id_t> &QueueOf(const FrameInfo &info) { return info.in_am_ ? am_ : a1in_; }
+
+ private:
+  size_t max_capacity_;
+  size_t kin_;   // target size of A1in
+  size_t kout_;  // max size of A1out
+  std::map<uint64_t, frame_id_t> a1in_;  // evictable frames of A1in, oldest first reference first
+  std::map<uint64_t, frame_id_t> am_;    // evictable frames of Am, least recently pinned first
+  size_t a1in_size_{0};                  // frames in A1in, evictable or not
+  uint64_t next_seq_{0};
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_map_;
+  std::unordered_map<frame_id_t, FrameInfo> frames_;
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_TWO_QUEUE_REPLACER_H
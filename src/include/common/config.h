@@ -13,8 +13,27 @@ static constexpr int META_PAGE_ID = 0;          // physical page id of the disk
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int PAGE_SIZE = 4096;                     // size of a data page in byte
+static constexpr int CACHE_LINE_SIZE = 64;                 // frame metadata is aligned to it against false sharing
+static constexpr int HUGE_PAGE_SIZE = 2 * 1024 * 1024;     // transparent huge page size the frame arena aligns to
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;       // ask for huge pages to back the frames of the buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;     // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;    // default number of buffer pool instances (shards), hits
+                                                           // skip the latch so more only help concurrent misses
+static constexpr int MAX_BUFFER_POOL_SIZE = 262144;        // frames a pool under a budget can grow to online
+static constexpr int MIN_BUFFER_POOL_SIZE = 64;            // frames a pool under a budget never shrinks below
+static constexpr int DEFAULT_BUFFER_POOL_BUDGET = 65536;   // frames shared by the databases of an ExecuteEngine
+static constexpr int DEFAULT_MEMORY_RESERVE = 16384;       // frames of memory a budget leaves to the rest of the system
+static constexpr int DEFAULT_PRESSURE_INTERVAL_MS = 1000;  // period at which a budget checks for memory pressure
+static constexpr int DEFAULT_SCAN_RING_SIZE = 32;          // frames recycled by a sequential scan
+static constexpr int DEFAULT_FLUSH_INTERVAL_MS = 100;      // period of the background flusher, 0 disables it
+static constexpr int CHECKPOINT_INTERVAL_MS = 5000;         // period at which the flusher checkpoints the disk manager
+static constexpr int DEFAULT_PREFETCH_DEPTH = 4;           // pages scans keep in flight ahead of them, 0 disables it
+static constexpr int DEFAULT_IO_QUEUE_DEPTH = 16;          // page I/Os a background worker keeps in flight
+static constexpr int DEFAULT_SCRUB_BATCH = 64;             // pages the scrubber visits between two pauses
+static constexpr double DEFAULT_FLUSH_CLEAN_RATIO = 0.25;  // share of frames the background flusher keeps clean
+static constexpr int BULK_LOAD_BATCH_SIZE = 4096;          // rows a load reads from its file per bulk insert
+static constexpr int ARENA_BLOCK_SIZE = 64 * 1024;         // bytes a query arena grows by
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
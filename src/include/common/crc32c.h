@@ -0,0 +1,19 @@
+#ifndef MINISQL_CRC32C_H
+#define MINISQL_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC32C (Castagnoli) of len bytes. Uses the SSE4.2 crc32 instruction when the CPU has it, a table driven version
+ * otherwise.
+ */
+uint32_t Crc32c(const void *data, size_t len);
+
+/** Table driven CRC32C, always available. */
+uint32_t Crc32cSoftware(const void *data, size_t len);
+
+/** @return whether Crc32c runs on the SSE4.2 crc32 instruction */
+bool Crc32cHardwareEnabled();
+
+#endif  // MINISQL_CRC32C_H
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 
+#include "buffer/buffer_pool_budget.h"
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
@@ -12,9 +13,30 @@
 #include "executor/execute_context.h"
 #include "storage/disk_manager.h"
 
+/**
+ * Tuning knobs of the storage layer of one database, the defaults suit an interactive session.
+ */
+struct StorageOptions {
+  uint32_t buffer_pool_instances_{DEFAULT_BUFFER_POOL_INSTANCES};
+  ReplacerType replacer_type_{ReplacerType::kLRU};
+  uint32_t flush_interval_ms_{DEFAULT_FLUSH_INTERVAL_MS};  // 0 disables the background flusher
+  double flush_clean_ratio_{DEFAULT_FLUSH_CLEAN_RATIO};    // share of frames the flusher keeps clean
+  uint32_t prefetch_depth_{DEFAULT_PREFETCH_DEPTH};        // pages scans read ahead, 0 disables read-ahead
+  bool preallocate_extents_{false};                        // reserve disk blocks for a whole extent when opening it
+  bool direct_io_{false};                                  // bypass the page cache of the kernel with O_DIRECT
+  bool mmap_reads_{false};                                 // read clean pages in place from a mapping of the file
+  bool page_checksums_{false};                             // stamp pages with a CRC32C and verify them on read
+  bool compress_pages_{false};                             // store pages LZ4 compressed, see DiskManager
+  uint32_t scrub_interval_ms_{0};                          // pause of the checksum scrubber, 0 disables it
+  bool warm_up_{false};                                    // dump the cached page ids at shutdown, reload them on open
+  BufferPoolBudget *budget_{nullptr};                      // shared budget sizing the pool, which may then grow up to
+                                                           // buffer_pool_size frames; null for a fixed size pool
+};
+
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           const StorageOptions &options = StorageOptions());
 
   ~DBStorageEngine();
 
@@ -26,6 +48,7 @@ class DBStorageEngine {
   CatalogManager *catalog_mgr_;
   std::string db_file_name_;
   bool init_;
+  StorageOptions options_;
 };
 
 #endif  // MINISQL_INSTANCE_H
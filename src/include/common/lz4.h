@@ -0,0 +1,23 @@
+#ifndef MINISQL_LZ4_H
+#define MINISQL_LZ4_H
+
+#include <cstddef>
+
+/**
+ * Minimal compressor and decompressor for the LZ4 block format, enough for pages. Blocks are compatible with
+ * LZ4_compress_default / LZ4_decompress_safe of the reference library, inputs larger than 64 KB are not supported.
+ */
+
+/**
+ * Compress src into dst.
+ * @return size of the compressed block, 0 if it does not fit into dst_capacity bytes
+ */
+int Lz4CompressBlock(const char *src, int src_size, char *dst, int dst_capacity);
+
+/**
+ * Decompress a block produced by Lz4CompressBlock, malformed input is detected rather than read or written past.
+ * @return number of bytes written to dst, -1 if the block is malformed or does not fit into dst_capacity bytes
+ */
+int Lz4DecompressBlock(const char *src, int src_size, char *dst, int dst_capacity);
+
+#endif  // MINISQL_LZ4_H
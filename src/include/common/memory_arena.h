@@ -0,0 +1,63 @@
+#ifndef MINISQL_MEMORY_ARENA_H
+#define MINISQL_MEMORY_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * MemoryArena hands out memory from large blocks by bumping a pointer, and frees it all at once when it is reset or
+ * destroyed. Destructors of the objects created in it are never run, so it only holds objects which own nothing
+ * outside of it, e.g. the Fields of a Row allocated from it, whose char data is in the arena as well.
+ *
+ * An arena is not thread safe, it is meant to be used by one query, see ExecuteContext.
+ */
+class MemoryArena {
+ public:
+  explicit MemoryArena(size_t block_size = ARENA_BLOCK_SIZE) : block_size_(block_size) {}
+
+  ~MemoryArena() = default;
+
+  DISALLOW_COPY_AND_MOVE(MemoryArena);
+
+  /** @return size bytes aligned to align, valid until the arena is reset or destroyed */
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  /** Construct a T in the arena, its destructor will not be run. */
+  template <typename T, typename... Args>
+  inline T *New(Args &&...args) {
+    return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /** @return a copy of the len bytes at data in the arena */
+  char *CopyBytes(const char *data, size_t len);
+
+  /** Free everything allocated so far, the first block is kept for what is allocated next. */
+  void Reset();
+
+  /** @return bytes handed out since the arena was created or reset */
+  inline size_t GetBytesAllocated() const { return bytes_allocated_; }
+
+  /** @return blocks the arena holds */
+  inline size_t GetBlockCount() const { return blocks_.size() + large_blocks_.size(); }
+
+ private:
+  static inline char *Align(char *ptr, size_t align) {
+    return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(align - 1));
+  }
+
+ private:
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;        // blocks of block_size_ bytes, the current one last
+  std::vector<std::unique_ptr<char[]>> large_blocks_;  // blocks of one large allocation each
+  char *cursor_{nullptr};  // next free byte of the current block
+  char *end_{nullptr};     // end of the current block
+  size_t bytes_allocated_{0};
+};
+
+#endif  // MINISQL_MEMORY_ARENA_H
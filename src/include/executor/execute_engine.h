@@ -41,6 +41,9 @@ class ExecuteEngine {
   void ExecuteInformation(dberr_t result);
 
  private:
+  /** Open a database whose buffer pool is sized by budget_. */
+  DBStorageEngine *OpenDatabase(const std::string &db_name, bool init);
+
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan);
 
   dberr_t ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *context);
@@ -69,11 +72,16 @@ class ExecuteEngine {
 
   dberr_t ExecuteTrxRollback(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteSet(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteLoadData(pSyntaxNode ast, ExecuteContext *context);
+
   dberr_t ExecuteExecfile(pSyntaxNode ast, ExecuteContext *context);
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
  private:
+  BufferPoolBudget budget_;                                /** memory shared by the buffer pools of all databases */
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
 };
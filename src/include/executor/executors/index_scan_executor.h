@@ -47,4 +47,6 @@ class IndexScanExecutor : public AbstractExecutor {
   vector<RowId> result_;
   size_t cursor_ = 0;
   bool is_schema_same_;
+  /** The tuples examined by Next, reset for every one of them */
+  MemoryArena scratch_;
 };
\ No newline at end of file
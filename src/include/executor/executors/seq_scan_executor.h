@@ -12,7 +12,8 @@
 #include "executor/plans/seq_scan_plan.h"
 
 /**
- * The SeqScanExecutor executor executes a sequential table scan.
+ * The SeqScanExecutor executor executes a sequential table scan. The predicate is evaluated on each tuple in place,
+ * through a RowView, and only the output columns of the rows it accepts are deserialized.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -39,8 +40,6 @@ class SeqScanExecutor : public AbstractExecutor {
 
   bool SchemaEqual(const Schema *table_schema, const Schema *output_schema);
 
-  void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
-
  private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
@@ -48,6 +47,7 @@ class SeqScanExecutor : public AbstractExecutor {
   TableIterator iterator_;
   const Schema *schema_{};
   bool is_schema_same_;
+  std::vector<uint32_t> columns_;  // the table column of each output column
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -2,9 +2,12 @@
 #define MINISQL_GENERIC_KEY_H
 
 #include <cstring>
+#include <vector>
 
 #include "record/field.h"
+#include "record/field_kernels.h"
 #include "record/row.h"
+#include "record/row_view.h"
 
 class GenericKey {
   friend class KeyManager;
@@ -35,24 +38,20 @@ class KeyManager {
   }
 
   // compare
+  /** The keys are compared in place, through the compare kernels of the key columns, without deserializing them. */
   [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
     //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
+    RowView lhs_key(lhs->data, key_schema_);
+    RowView rhs_key(rhs->data, key_schema_);
 
-    for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
-
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
+    for (uint32_t i = 0; i < compare_kernels_.size(); i++) {
+      // a null is neither less nor greater than anything
+      if (lhs_key.IsNull(i) || rhs_key.IsNull(i)) {
+        continue;
       }
-
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
+      int cmp = compare_kernels_[i](lhs_key.GetField(i), rhs_key.GetField(i));
+      if (cmp != 0) {
+        return cmp < 0 ? -1 : 1;
       }
     }
     // equals
@@ -64,14 +63,20 @@ class KeyManager {
   KeyManager(const KeyManager &other) {
     this->key_schema_ = other.key_schema_;
     this->key_size_ = other.key_size_;
+    this->compare_kernels_ = other.compare_kernels_;
   }
 
   // constructor
-  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {}
+  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {
+    for (auto column : key_schema->GetColumns()) {
+      compare_kernels_.push_back(GetCompareKernel(column->GetType()));
+    }
+  }
 
  private:
   int key_size_;
   Schema *key_schema_;
+  std::vector<FieldCompareKernel> compare_kernels_;  // of each key column
 };
 
 #endif  // MINISQL_GENERIC_KEY_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_INDEX_ITERATOR_H
 #define MINISQL_INDEX_ITERATOR_H
 
+#include "buffer/page_guard.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 class IndexIterator {
@@ -12,6 +13,11 @@ class IndexIterator {
 
   explicit IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index = 0);
 
+  // the iterator owns the pin of its current leaf, so it can be moved but not copied
+  IndexIterator(IndexIterator &&that) noexcept;
+
+  IndexIterator &operator=(IndexIterator &&that) noexcept;
+
   ~IndexIterator();
 
   /** Return the key/value pair this iterator is currently pointing at. */
@@ -32,6 +38,7 @@ class IndexIterator {
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
   // add your own private member variables here
+  PageGuard page_guard;  // pins the leaf of current_page_id, empty at the end
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
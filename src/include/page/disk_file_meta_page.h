@@ -2,19 +2,27 @@
 #define MINISQL_DISK_FILE_META_PAGE_H
 
 #include <cstdint>
+#include <limits>
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+// further meta pages count the extents one meta page has no room for, so only the page id type limits the file
+static constexpr page_id_t MAX_VALID_PAGE_ID = std::numeric_limits<page_id_t>::max();
 
+/**
+ * A meta page counts the used pages of up to EXTENTS_PER_META_PAGE extents. The first meta page of the file also holds
+ * the totals of the whole file, the counters in the header of the meta pages after it are unused.
+ */
 class DiskFileMetaPage {
  public:
+  static constexpr uint32_t EXTENTS_PER_META_PAGE = (PAGE_SIZE - 8) / 4;
+
   uint32_t GetExtentNums() { return num_extents_; }
 
   uint32_t GetAllocatedPages() { return num_allocated_pages_; }
 
   uint32_t GetExtentUsedPage(uint32_t extent_id) {
-    if (extent_id >= num_extents_) {
+    if (extent_id >= num_extents_ || extent_id >= EXTENTS_PER_META_PAGE) {
       return 0;
     }
     return extent_used_page_[extent_id];
@@ -0,0 +1,70 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+/**
+ * Free space map page format, the pages of one map are chained through NextPageId:
+ *  ------------------------------------------------------------------------------------------------------
+ *  | PageId (4) | LSN (4) | NextPageId (4) | EntryCount (4) | PageId_1 (4) | ... | Category_1 (1) | ... |
+ *  ------------------------------------------------------------------------------------------------------
+ *
+ * Entry i records a page of the table heap and its free space category, the number of CATEGORY_SIZE byte units of
+ * free space the page has at least.
+ **/
+
+#include <cstring>
+
+#include "common/config.h"
+#include "page/page.h"
+
+class FreeSpaceMapPage : public Page {
+ public:
+  void Init(page_id_t page_id) {
+    memcpy(GetData(), &page_id, sizeof(page_id));
+    SetNextPageId(INVALID_PAGE_ID);
+    SetEntryCount(0);
+  }
+
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  uint32_t GetEntryCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRY_COUNT); }
+
+  void SetEntryCount(uint32_t entry_count) {
+    memcpy(GetData() + OFFSET_ENTRY_COUNT, &entry_count, sizeof(uint32_t));
+  }
+
+  page_id_t GetHeapPageId(uint32_t index) { return reinterpret_cast<page_id_t *>(GetData() + OFFSET_ENTRIES)[index]; }
+
+  uint8_t GetCategory(uint32_t index) {
+    return reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES)[index];
+  }
+
+  void SetCategory(uint32_t index, uint8_t category) {
+    reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES)[index] = category;
+  }
+
+  /** Record one more heap page, the page must not be full. */
+  void AppendEntry(page_id_t heap_page_id, uint8_t category) {
+    uint32_t index = GetEntryCount();
+    memcpy(GetData() + OFFSET_ENTRIES + index * sizeof(page_id_t), &heap_page_id, sizeof(page_id_t));
+    SetCategory(index, category);
+    SetEntryCount(index + 1);
+  }
+
+ private:
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 8;
+  static constexpr size_t OFFSET_ENTRY_COUNT = 12;
+  static constexpr size_t OFFSET_ENTRIES = 16;
+
+ public:
+  /** Bytes of free space one category stands for, so that a category fits in a byte. */
+  static constexpr uint32_t CATEGORY_SIZE = PAGE_SIZE / 256;
+  static constexpr uint32_t MAX_ENTRIES = (PAGE_SIZE - OFFSET_ENTRIES) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+ private:
+  static constexpr size_t OFFSET_CATEGORIES = OFFSET_ENTRIES + MAX_ENTRIES * sizeof(page_id_t);
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
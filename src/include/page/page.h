@@ -1,8 +1,10 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -12,22 +14,30 @@
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data of a page in the buffer pool lives in the FrameArena of its instance, the Page object only holds the
+ * metadata, aligned to a cache line so that pinning one frame does not invalidate the line of its neighbour.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a page outside of the buffer pool, which owns its data. Zeros out the page data. */
+  Page() : data_(new (std::align_val_t(PAGE_SIZE)) char[PAGE_SIZE]()), owns_data_(true) {}
 
-  /** Default destructor. */
-  ~Page() = default;
+  ~Page() {
+    if (owns_data_) ::operator delete[](data_, std::align_val_t(PAGE_SIZE));
+  }
 
-  /** @return the actual data contained within this page */
-  inline char *GetData() { return data_; }
+  /** @return the actual data contained within this page, which may live in a read-only mapping of the db file */
+  inline char *GetData() {
+    char *mapped_data = mapped_data_.load(std::memory_order_acquire);
+    return mapped_data == nullptr ? data_ : mapped_data;
+  }
 
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
@@ -38,6 +48,9 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
+  /** @return true if the page is read in place from the mapped db file */
+  inline bool IsMapped() { return mapped_data_ != nullptr; }
+
   /** Acquire the page write latch. */
   inline void WLatch() { rwlatch_.WLock(); }
 
@@ -65,17 +78,27 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** Constructor of a frame of the buffer pool, data is its already zeroed slot of the frame arena. */
+  explicit Page(char *data) : data_(data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes aligned to PAGE_SIZE. */
+  char *const data_;
+  /** True for a page outside of the buffer pool, which frees data_. */
+  const bool owns_data_{false};
+  /** If not null, the page is read in place from this address of the mapped db file instead of from data_. */
+  std::atomic<char *> mapped_data_{nullptr};
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /**
+   * The pin count of this page, pinned and unpinned without the latch of the buffer pool on a hit. It is negative while
+   * the buffer pool has claimed the frame to load another page into it.
+   */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
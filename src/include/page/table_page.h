@@ -25,6 +25,7 @@
 #include "concurrency/txn.h"
 #include "page/page.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "recovery/log_manager.h"
 
 class TablePage : public Page {
@@ -37,6 +38,9 @@ class TablePage : public Page {
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** Follow the page chain of a table heap, see BufferPoolManager::PrefetchChain */
+  static page_id_t NextPageIdOf(Page *page) { return reinterpret_cast<TablePage *>(page)->GetNextPageId(); }
+
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
   }
@@ -45,8 +49,22 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
   }
 
+  uint32_t GetFreeSpaceRemaining() {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return the free space a row of serialized_size bytes takes on a page, its slot included */
+  static uint32_t GetInsertSize(uint32_t serialized_size) { return serialized_size + SIZE_TUPLE; }
+
   bool InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
 
+  /**
+   * Insert a tuple into a new slot at the end of the slot array, without looking for a slot to reuse. Meant for bulk
+   * loading pages, which have no deleted slots.
+   * @param serialized_size row.GetSerializedSize(schema), which the caller has computed already
+   */
+  bool AppendTuple(Row &row, uint32_t serialized_size, Schema *schema);
+
   bool MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
 
   bool UpdateTuple(Row &new_row, Row *old_row, Schema *schema, Txn *txn, LockManager *lock_manager,
@@ -58,6 +76,9 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
 
+  /** Point view at the tuple of rid in place, the page must stay read latched while the view is in use. */
+  bool GetTupleView(const RowId &rid, Schema *schema, RowView *view);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
@@ -73,10 +94,6 @@ class TablePage : public Page {
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -1,5 +1,6 @@
 %{
   #include <stdio.h>
+  #include <string.h>
   #include "parser/parser.h"
 
   extern char *yytext;
@@ -27,7 +28,7 @@
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
-%type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_quit sql_exec_file sql_set sql_load_data
 
 %%
 
@@ -58,6 +59,8 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_set { $$ = $1; }
+  | sql_load_data { $$ = $1; }
   ;
 
 sql_create_database:
@@ -362,6 +365,36 @@ update_value:
   }
   ;
 
+sql_set:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSet, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
+/* copy and load are not keywords, so that they can still name tables and columns */
+sql_load_data:
+  IDENTIFIER IDENTIFIER FROM STRING {
+    if (strcmp($1->val_, "copy") != 0) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoadData, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  | IDENTIFIER IDENTIFIER IDENTIFIER STRING INTO TABLE IDENTIFIER {
+    if (strcmp($1->val_, "load") != 0 || strcmp($2->val_, "data") != 0 || strcmp($3->val_, "infile") != 0) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoadData, NULL);
+    SyntaxNodeAddChildren($$, $7);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
 sql_trx_begin:
   TRXBEGIN {
     $$ = CreateSyntaxNode(kNodeTrxBegin, NULL);
@@ -43,7 +43,9 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin recovery command */
   kNodeTrxCommit,            /** commit recovery command */
-  kNodeTrxRollback           /** rollback recovery command */
+  kNodeTrxRollback,          /** rollback recovery command */
+  kNodeSet,                  /** set command, assigns a number to a system variable */
+  kNodeLoadData              /** load data / copy command, bulk loads a csv file into a table */
 } SyntaxNodeType;
 
 /**
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "abstract_expression.h"
+#include "record/field_kernels.h"
 #include "record/schema.h"
 
 /**
@@ -18,7 +19,9 @@ class ComparisonExpression : public AbstractExpression {
   /** Creates a new comparison expression representing (left comp_type right). */
   ComparisonExpression(AbstractExpressionRef left, AbstractExpressionRef right, string comp_type)
       : AbstractExpression({std::move(left), std::move(right)}, TypeId::kTypeInt, ExpressionType::ComparisonExpression),
-        comp_type_{std::move(comp_type)} {}
+        comp_type_{std::move(comp_type)},
+        op_{ParseComparisonType(comp_type_)},
+        compare_{GetCompareKernel(GetChildAt(0)->GetReturnType())} {}
 
   /** e.g. evaluate the result of id = 1 */
   Field Evaluate(const Row *row) const override {
@@ -27,6 +30,12 @@ class ComparisonExpression : public AbstractExpression {
     return Field(kTypeInt, PerformComparison(lhs, rhs));
   }
 
+  Field Evaluate(const RowView &view) const override {
+    Field lhs = GetChildAt(0)->Evaluate(view);
+    Field rhs = GetChildAt(1)->Evaluate(view);
+    return Field(kTypeInt, PerformComparison(lhs, rhs));
+  }
+
   Field EvaluateJoin(const Row *left_row, const Row *right_row) const override {
     Field lhs = GetChildAt(0)->EvaluateJoin(left_row, right_row);
     Field rhs = GetChildAt(1)->EvaluateJoin(left_row, right_row);
@@ -36,28 +45,57 @@ class ComparisonExpression : public AbstractExpression {
   std::string GetComparisonType() { return comp_type_; }
 
  private:
-  CmpBool PerformComparison(const Field &lhs, const Field &rhs) const {
-    if (comp_type_ == "=")
-      return lhs.CompareEquals(rhs);
-    else if (comp_type_ == "<>")
-      return lhs.CompareNotEquals(rhs);
-    else if (comp_type_ == "<")
-      return lhs.CompareLessThan(rhs);
-    else if (comp_type_ == "<=")
-      return lhs.CompareLessThanEquals(rhs);
-    else if (comp_type_ == ">")
-      return lhs.CompareGreaterThan(rhs);
-    else if (comp_type_ == ">=")
-      return lhs.CompareGreaterThanEquals(rhs);
-    else if (comp_type_ == "is")
-      return GetCmpBool(lhs.IsNull());
-    else if (comp_type_ == "not")
-      return GetCmpBool(!lhs.IsNull());
+  enum class ComparisonOp { kEquals, kNotEquals, kLessThan, kLessThanEquals, kGreaterThan, kGreaterThanEquals, kIs, kNot };
+
+  static ComparisonOp ParseComparisonType(const std::string &comp_type) {
+    if (comp_type == "=")
+      return ComparisonOp::kEquals;
+    else if (comp_type == "<>")
+      return ComparisonOp::kNotEquals;
+    else if (comp_type == "<")
+      return ComparisonOp::kLessThan;
+    else if (comp_type == "<=")
+      return ComparisonOp::kLessThanEquals;
+    else if (comp_type == ">")
+      return ComparisonOp::kGreaterThan;
+    else if (comp_type == ">=")
+      return ComparisonOp::kGreaterThanEquals;
+    else if (comp_type == "is")
+      return ComparisonOp::kIs;
+    else if (comp_type == "not")
+      return ComparisonOp::kNot;
     else
       throw std::logic_error("Unsupported comparison type");
   }
 
+  /** The operator and the compare kernel of the operands are picked when the expression is built, not per row. */
+  CmpBool PerformComparison(const Field &lhs, const Field &rhs) const {
+    if (op_ == ComparisonOp::kIs) return GetCmpBool(lhs.IsNull());
+    if (op_ == ComparisonOp::kNot) return GetCmpBool(!lhs.IsNull());
+    ASSERT(lhs.CheckComparable(rhs), "Not comparable.");
+    if (lhs.IsNull() || rhs.IsNull()) {
+      return CmpBool::kNull;
+    }
+    int cmp = compare_(lhs, rhs);
+    switch (op_) {
+      case ComparisonOp::kEquals:
+        return GetCmpBool(cmp == 0);
+      case ComparisonOp::kNotEquals:
+        return GetCmpBool(cmp != 0);
+      case ComparisonOp::kLessThan:
+        return GetCmpBool(cmp < 0);
+      case ComparisonOp::kLessThanEquals:
+        return GetCmpBool(cmp <= 0);
+      case ComparisonOp::kGreaterThan:
+        return GetCmpBool(cmp > 0);
+      default:
+        return GetCmpBool(cmp >= 0);
+    }
+  }
+
   std::string comp_type_;
+  ComparisonOp op_;
+  FieldCompareKernel compare_;
 };
 
 #endif  // MINISQL_COMPARISON_EXPRESSION_H
@@ -0,0 +1,46 @@
+#ifndef MINISQL_CSV_READER_H
+#define MINISQL_CSV_READER_H
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * CsvReader turns the lines of a comma separated file into rows of a schema, one line per row with one cell per
+ * column. A cell may be quoted with double quotes, a quote inside it is written twice. An empty unquoted cell is null.
+ */
+class CsvReader {
+ public:
+  CsvReader(std::istream &in, const Schema *schema) : in_(in), schema_(schema) {}
+
+  /**
+   * Append up to max_rows rows read from the file to rows. Reading stops for good at the first malformed line, the rows
+   * before it in the same call are still appended.
+   * @return number of rows appended, fewer than max_rows at the end of the file or on a malformed line, see GetError
+   */
+  size_t ReadRows(std::vector<Row> *rows, size_t max_rows);
+
+  /** @return a message about the first malformed line, empty if none was met */
+  inline const std::string &GetError() const { return error_; }
+
+  /** @return number of the last line read, from 1 */
+  inline size_t GetLineNumber() const { return line_no_; }
+
+ private:
+  /** Split line into its cells. */
+  bool SplitLine(const std::string &line, std::vector<std::string> *cells, std::vector<bool> *quoted);
+
+  /** Build the fields of a row from its cells. */
+  bool ParseCells(const std::vector<std::string> &cells, const std::vector<bool> &quoted, std::vector<Field> *fields);
+
+ private:
+  std::istream &in_;
+  const Schema *schema_;
+  size_t line_no_{0};
+  std::string error_;
+};
+
+#endif  // MINISQL_CSV_READER_H
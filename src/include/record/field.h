@@ -18,6 +18,9 @@ class Field {
 
   friend class TypeFloat;
 
+  template <TypeId type>
+  friend struct FieldKernels;
+
  public:
   explicit Field(const TypeId type) : type_id_(type), len_(FIELD_NULL_LEN), is_null_(true) {}
 
@@ -75,6 +78,16 @@ class Field {
     }
   }
 
+  // move constructor, the data other owned is handed over
+  Field(Field &&other) noexcept
+      : value_(other.value_),
+        type_id_(other.type_id_),
+        len_(other.len_),
+        is_null_(other.is_null_),
+        manage_data_(other.manage_data_) {
+    other.manage_data_ = false;
+  }
+
   // copy
   Field &operator=(Field &other) {
     Swap(*this, other);
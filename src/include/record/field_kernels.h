@@ -0,0 +1,110 @@
+#ifndef MINISQL_FIELD_KERNELS_H
+#define MINISQL_FIELD_KERNELS_H
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+#include "record/field.h"
+
+/**
+ * FieldKernels<type> compares and serializes the fields of one TypeId directly, where the methods of Field go through
+ * a virtual call on the Type singleton of the field for every operation. A caller picks the kernels of a column once,
+ * e.g. when a plan, an index or a RowLayout is built, with the Get*Kernel functions below, and calls them through a
+ * plain function pointer afterwards. Types without a specialization get kernels calling the virtual Type methods.
+ *
+ * The fields handed to a kernel must be of its type, Compare takes non null fields only.
+ */
+template <TypeId type>
+struct FieldKernels;
+
+/** @return <0, 0 or >0 as left is less than, equal to or greater than right */
+using FieldCompareKernel = int (*)(const Field &left, const Field &right);
+/** Same as Field::SerializeTo. */
+using FieldSerializeKernel = uint32_t (*)(const Field &field, char *buf);
+
+template <>
+struct FieldKernels<TypeId::kTypeInt> {
+  static int Compare(const Field &left, const Field &right) {
+    return (left.value_.integer_ > right.value_.integer_) - (left.value_.integer_ < right.value_.integer_);
+  }
+
+  static uint32_t SerializeTo(const Field &field, char *buf) {
+    if (field.is_null_) return 0;
+    MACH_WRITE_TO(int32_t, buf, field.value_.integer_);
+    return sizeof(int32_t);
+  }
+};
+
+template <>
+struct FieldKernels<TypeId::kTypeFloat> {
+  static int Compare(const Field &left, const Field &right) {
+    return (left.value_.float_ > right.value_.float_) - (left.value_.float_ < right.value_.float_);
+  }
+
+  static uint32_t SerializeTo(const Field &field, char *buf) {
+    if (field.is_null_) return 0;
+    MACH_WRITE_TO(float, buf, field.value_.float_);
+    return sizeof(float);
+  }
+};
+
+template <>
+struct FieldKernels<TypeId::kTypeChar> {
+  static inline const char *GetData(const Field &field) { return field.value_.chars_; }
+
+  static inline uint32_t GetLength(const Field &field) { return field.len_; }
+
+  static int Compare(const Field &left, const Field &right) {
+    int ret = memcmp(left.value_.chars_, right.value_.chars_, std::min(left.len_, right.len_));
+    if (ret == 0 && left.len_ != right.len_) {
+      ret = left.len_ < right.len_ ? -1 : 1;
+    }
+    return ret;
+  }
+
+  static uint32_t SerializeTo(const Field &field, char *buf) {
+    if (field.is_null_) return 0;
+    MACH_WRITE_UINT32(buf, field.len_);
+    memcpy(buf + sizeof(uint32_t), field.value_.chars_, field.len_);
+    return sizeof(uint32_t) + field.len_;
+  }
+};
+
+/** The virtual path, for types without kernels of their own. */
+struct VirtualFieldKernels {
+  static int Compare(const Field &left, const Field &right) {
+    if (left.CompareLessThan(right) == CmpBool::kTrue) return -1;
+    return left.CompareGreaterThan(right) == CmpBool::kTrue ? 1 : 0;
+  }
+
+  static uint32_t SerializeTo(const Field &field, char *buf) { return field.SerializeTo(buf); }
+};
+
+inline FieldCompareKernel GetCompareKernel(TypeId type) {
+  switch (type) {
+    case TypeId::kTypeInt:
+      return &FieldKernels<TypeId::kTypeInt>::Compare;
+    case TypeId::kTypeFloat:
+      return &FieldKernels<TypeId::kTypeFloat>::Compare;
+    case TypeId::kTypeChar:
+      return &FieldKernels<TypeId::kTypeChar>::Compare;
+    default:
+      return &VirtualFieldKernels::Compare;
+  }
+}
+
+inline FieldSerializeKernel GetSerializeKernel(TypeId type) {
+  switch (type) {
+    case TypeId::kTypeInt:
+      return &FieldKernels<TypeId::kTypeInt>::SerializeTo;
+    case TypeId::kTypeFloat:
+      return &FieldKernels<TypeId::kTypeFloat>::SerializeTo;
+    case TypeId::kTypeChar:
+      return &FieldKernels<TypeId::kTypeChar>::SerializeTo;
+    default:
+      return &VirtualFieldKernels::SerializeTo;
+  }
+}
+
+#endif  // MINISQL_FIELD_KERNELS_H
@@ -5,12 +5,21 @@
 #include <vector>
 
 #include "common/macros.h"
+#include "common/memory_arena.h"
 #include "common/rowid.h"
 #include "record/field.h"
 #include "record/schema.h"
 
 /**
- *  Row format:
+ *  Row format, FORMAT_FIXED_FIRST of RowLayout, which rows are written in:
+ * ------------------------------------------------------------------------------
+ * | Header | Null bitmap | Fixed section | Var offset table | Var data |
+ * ------------------------------------------------------------------------------
+ *  Header: format (1 byte) | field nums (3 bytes), a uint32
+ *  Fixed section: the int and float fields at constant offsets, zeroed when null
+ *  Var offset table: for each char column, the offset from the row at which its data ends
+ *
+ *  FORMAT_LEGACY, which rows written before are still read in:
  * -------------------------------------------
  * | Header | Field-1 | ... | Field-N |
  * -------------------------------------------
@@ -18,8 +27,7 @@
  * --------------------------------------------
  * | Field Nums | Null bitmap |
  * -------------------------------------------
- *
- *
+ *  where null fields are skipped and a char field is its length followed by its data.
  */
 class Row {
  public:
@@ -36,8 +44,11 @@ class Row {
 
   void destroy() {
     if (!fields_.empty()) {
-      for (auto field : fields_) {
-        delete field;
+      // the fields of a row allocated from an arena are released with the arena
+      if (arena_ == nullptr) {
+        for (auto field : fields_) {
+          delete field;
+        }
       }
       fields_.clear();
     }
@@ -56,33 +67,68 @@ class Row {
   Row(RowId rid) : rid_(rid) {}
 
   /**
-   * Row copy function, deep copy
+   * Row used for deserialize during a query, whose fields are allocated from arena and released with it
    */
-  Row(const Row &other) {
-    destroy();
-    rid_ = other.rid_;
+  explicit Row(MemoryArena *arena) : arena_(arena) {}
+
+  /**
+   * Row copy function, deep copy, the copy allocates its fields on the heap
+   */
+  Row(const Row &other) : rid_(other.rid_) {
+    fields_.reserve(other.fields_.size());
     for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+      AppendField(*field);
     }
   }
 
   /**
-   * Assign operator, deep copy
+   * Row move function, the fields are handed over along with the arena they are allocated from
+   */
+  Row(Row &&other) noexcept : rid_(other.rid_), fields_(std::move(other.fields_)), arena_(other.arena_) {
+    other.fields_.clear();
+  }
+
+  /**
+   * Assign operator, deep copy, the fields are allocated the way this row allocates its own
    */
   Row &operator=(const Row &other) {
+    if (this == &other) return *this;
     destroy();
     rid_ = other.rid_;
+    fields_.reserve(other.fields_.size());
     for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+      AppendField(*field);
     }
     return *this;
   }
 
+  /**
+   * Move assign operator, the fields are handed over along with the arena they are allocated from
+   */
+  Row &operator=(Row &&other) noexcept {
+    if (this == &other) return *this;
+    destroy();
+    rid_ = other.rid_;
+    fields_ = std::move(other.fields_);
+    other.fields_.clear();
+    arena_ = other.arena_;
+    return *this;
+  }
+
+  /**
+   * Append a deep copy of field, allocated from the arena of the row if it has one, on the heap otherwise
+   */
+  void AppendField(const Field &field);
+
+  /** @return the arena the fields of the row are allocated from, null if they are on the heap */
+  inline MemoryArena *GetArena() const { return arena_; }
+
   /**
    * Note: Make sure that bytes write to buf is equal to GetSerializedSize()
    */
   uint32_t SerializeTo(char *buf, Schema *schema) const;
 
+  /** Read a row of either format. */
   uint32_t DeserializeFrom(char *buf, Schema *schema);
 
   /**
@@ -98,6 +144,7 @@ class Row {
 
   inline void SetRowId(RowId rid) { rid_ = rid; }
 
+  /** Fields added through it must be allocated the way the row allocates its own, see AppendField. */
   inline std::vector<Field *> &GetFields() { return fields_; }
 
   inline Field *GetField(uint32_t idx) const {
@@ -110,6 +157,7 @@ class Row {
  private:
   RowId rid_{};
   std::vector<Field *> fields_; /** Make sure that all field ptr are destructed*/
+  MemoryArena *arena_{nullptr}; /** null if the fields are allocated on the heap */
 };
 
 #endif  // MINISQL_ROW_H
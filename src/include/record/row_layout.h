@@ -0,0 +1,95 @@
+#ifndef MINISQL_ROW_LAYOUT_H
+#define MINISQL_ROW_LAYOUT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "common/macros.h"
+#include "record/column.h"
+#include "record/field_kernels.h"
+
+/**
+ * RowLayout places the columns of a schema in a row of format FORMAT_FIXED_FIRST, see Row, so that any field of such
+ * a row is found in O(1), without reading the fields before it:
+ *  - each fixed size column has a constant offset, in the fixed section right after the null bitmap
+ *  - each char column has a constant offset into the var offset table, whose entries are the offsets at which the
+ *    data of the char columns end, the data of a char column starts where the one of the previous char column ends
+ *
+ * A layout is computed once per Schema, see Schema::GetLayout, along with the serialize kernels of the fixed size
+ * columns.
+ */
+class RowLayout {
+ public:
+  /** Fields one after the other, a char field prefixed with its length. Rows of this format are only read. */
+  static constexpr uint32_t FORMAT_LEGACY = 0;
+  /** Null bitmap, fixed section, var offset table, var data. */
+  static constexpr uint32_t FORMAT_FIXED_FIRST = 1;
+
+  explicit RowLayout(const std::vector<Column *> &columns);
+
+  /** @return the first word of a row, its format in the high byte and its field count in the others */
+  static inline uint32_t MakeHeader(uint32_t format, uint32_t field_count) {
+    ASSERT(field_count <= FIELD_COUNT_MASK, "Too many fields in a row.");
+    return (format << FORMAT_SHIFT) | field_count;
+  }
+
+  static inline uint32_t GetFormat(const char *row) { return MACH_READ_UINT32(row) >> FORMAT_SHIFT; }
+
+  static inline uint32_t GetFieldCount(const char *row) { return MACH_READ_UINT32(row) & FIELD_COUNT_MASK; }
+
+  inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(slots_.size()); }
+
+  inline uint32_t GetNullBitmapOffset() const { return sizeof(uint32_t); }
+
+  inline uint32_t GetNullBitmapSize() const { return (GetColumnCount() + 7) / 8; }
+
+  inline bool IsFixed(uint32_t idx) const { return slots_[idx].fixed_; }
+
+  /** @return offset of the field of fixed column idx, or of the var offset table entry of char column idx */
+  inline uint32_t GetSlotOffset(uint32_t idx) const { return slots_[idx].offset_; }
+
+  /** @return the kernel writing the field of fixed column idx */
+  inline FieldSerializeKernel GetSerializeKernel(uint32_t idx) const { return slots_[idx].serialize_; }
+
+  /** @return offset of the var data, also the size of a row without any char data */
+  inline uint32_t GetVarDataOffset() const { return var_data_offset_; }
+
+  /**
+   * @param row a row of format FORMAT_FIXED_FIRST
+   * @param[out] len length of the data of field idx, 0 for a null char field
+   * @return offset of the data of field idx
+   */
+  inline uint32_t GetFieldOffset(const char *row, uint32_t idx, uint32_t *len) const {
+    const Slot &slot = slots_[idx];
+    if (slot.fixed_) {
+      *len = slot.size_;
+      return slot.offset_;
+    }
+    uint32_t begin = slot.offset_ == var_table_offset_ ? var_data_offset_ : MACH_READ_UINT32(row + slot.offset_ - 4);
+    *len = MACH_READ_UINT32(row + slot.offset_) - begin;
+    return begin;
+  }
+
+  /** @return size of a row of format FORMAT_FIXED_FIRST, which is where its last char field ends */
+  inline uint32_t GetRowSize(const char *row) const {
+    return var_table_offset_ == var_data_offset_ ? var_data_offset_
+                                                 : MACH_READ_UINT32(row + var_data_offset_ - sizeof(uint32_t));
+  }
+
+ private:
+  static constexpr uint32_t FORMAT_SHIFT = 24;
+  static constexpr uint32_t FIELD_COUNT_MASK = (1u << FORMAT_SHIFT) - 1;
+
+  struct Slot {
+    bool fixed_;
+    uint32_t offset_;
+    uint32_t size_;                   // size of a fixed column, 0 for a char column
+    FieldSerializeKernel serialize_;  // of a fixed column, null for a char column
+  };
+
+  std::vector<Slot> slots_;
+  uint32_t var_table_offset_{0};
+  uint32_t var_data_offset_{0};
+};
+
+#endif  // MINISQL_ROW_LAYOUT_H
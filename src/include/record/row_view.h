@@ -0,0 +1,73 @@
+#ifndef MINISQL_ROW_VIEW_H
+#define MINISQL_ROW_VIEW_H
+
+#include <vector>
+
+#include "common/rowid.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * RowView reads the fields of a serialized row, see Row, in place, without allocating a Field per column. In a row of
+ * format FORMAT_FIXED_FIRST a field is found in O(1) through the RowLayout of the schema. In a row of format
+ * FORMAT_LEGACY the offset of each field is found from the null bitmap and the lengths of the fields before it, the
+ * first time a field at or past it is read.
+ *
+ * The view does not own the bytes it reads, they must stay valid and unchanged while it is used, e.g. a tuple of a
+ * pinned TablePage whose read latch is held. A view is meant to be reused, Reset keeps its memory.
+ */
+class RowView {
+ public:
+  RowView() = default;
+
+  RowView(const char *data, const Schema *schema, RowId rid = INVALID_ROWID) { Reset(data, schema, rid); }
+
+  /** Point the view at another serialized row. */
+  void Reset(const char *data, const Schema *schema, RowId rid = INVALID_ROWID);
+
+  inline RowId GetRowId() const { return rid_; }
+
+  inline uint32_t GetFieldCount() const { return field_count_; }
+
+  inline bool IsNull(uint32_t idx) const {
+    ASSERT(idx < field_count_, "Failed to access field");
+    return (null_bitmap_[idx / 8] >> (idx % 8)) & 1;
+  }
+
+  /**
+   * @return the field at idx, a char field points into the viewed bytes rather than owning a copy of them, so it must
+   * not outlive them
+   */
+  Field GetField(uint32_t idx) const;
+
+  /** @return bytes the viewed row takes */
+  uint32_t GetSerializedSize() const;
+
+  /** Replace the fields of row with deep copies of all the fields of the view, and set its row id. */
+  void Materialize(Row *row) const;
+
+  /** Replace the fields of row with deep copies of the fields at columns, in that order, and set its row id. */
+  void Materialize(const std::vector<uint32_t> &columns, Row *row) const;
+
+ private:
+  /**
+   * @param[out] len length of the data of the non-null field at idx
+   * @return the data of the field at idx, the characters themselves for a char field
+   */
+  const char *GetFieldData(uint32_t idx, uint32_t *len) const;
+
+  /** @return the offset from data_ of the field at idx of a legacy row, resolving the offsets up to it if needed */
+  uint32_t GetLegacyOffset(uint32_t idx) const;
+
+ private:
+  const char *data_{nullptr};
+  const Schema *schema_{nullptr};
+  const RowLayout *layout_{nullptr};  // null for a legacy row
+  RowId rid_;
+  uint32_t field_count_{0};
+  const uint8_t *null_bitmap_{nullptr};
+  mutable std::vector<uint32_t> offsets_;  // of a legacy row, offsets_[i] is the offset of field i if resolved already
+};
+
+#endif  // MINISQL_ROW_VIEW_H
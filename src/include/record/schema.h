@@ -6,6 +6,7 @@
 #include "common/macros.h"
 #include "glog/logging.h"
 #include "record/column.h"
+#include "record/row_layout.h"
 
 #ifndef MINISQL_SCHEMA_H
 #define MINISQL_SCHEMA_H
@@ -13,7 +14,7 @@
 class Schema {
  public:
   explicit Schema(const std::vector<Column *> columns, bool is_manage_ = true)
-      : columns_(std::move(columns)), is_manage_(is_manage_) {}
+      : columns_(std::move(columns)), is_manage_(is_manage_), layout_(columns_) {}
 
   ~Schema() {
     if (is_manage_) {
@@ -39,6 +40,9 @@ class Schema {
 
   inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
 
+  /** @return where the columns are placed in a serialized row */
+  inline const RowLayout &GetLayout() const { return layout_; }
+
   /**
    * Shallow copy schema, only used in index
    *
@@ -84,6 +88,7 @@ class Schema {
   static constexpr uint32_t SCHEMA_MAGIC_NUM = 200715;
   std::vector<Column *> columns_;
   bool is_manage_ = false; /** if false, don't need to delete pointer to column */
+  RowLayout layout_;
 };
 
 using IndexSchema = Schema;
@@ -0,0 +1,107 @@
+#ifndef MINISQL_ASYNC_IO_H
+#define MINISQL_ASYNC_IO_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common/config.h"
+
+class DiskManager;
+
+/** Called once an asynchronous page I/O has completed, ok is false if it failed. */
+using IOCallback = std::function<void(bool ok)>;
+
+/**
+ * AsyncIO keeps up to queue_depth page reads and writes of one DiskManager in flight at the same time. On Linux it is
+ * backed by an io_uring instance, elsewhere, when the kernel refuses to set one up, or when the disk manager compresses
+ * its pages, every request is carried out with ReadPage/WritePage as soon as it is queued.
+ *
+ * An AsyncIO object is meant to be driven by a single thread, each background worker creates its own through
+ * DiskManager::CreateAsyncIO. Callbacks always run on that thread, from Submit*, Poll or Wait.
+ */
+class AsyncIO {
+ public:
+  explicit AsyncIO(DiskManager *disk_manager, size_t queue_depth = DEFAULT_IO_QUEUE_DEPTH, bool use_io_uring = true);
+
+  /** Waits for the requests still in flight. */
+  ~AsyncIO();
+
+  /**
+   * Queue a read of a page into page_data, which must stay valid until callback has run. A page beyond the end of the
+   * file reads as zeros, a page which does not match its checksum fails. Requests are handed to the kernel by Submit,
+   * or here already if the queue is full.
+   */
+  void SubmitRead(page_id_t logical_page_id, char *page_data, IOCallback callback);
+
+  /** Queue a write of page_data, which must stay valid and unchanged until callback has run. */
+  void SubmitWrite(page_id_t logical_page_id, const char *page_data, IOCallback callback);
+
+  /**
+   * Hand every queued request to the kernel with one system call.
+   * @return number of requests submitted
+   */
+  size_t Submit();
+
+  /**
+   * Run the callbacks of the requests which have completed, without blocking.
+   * @return number of callbacks run
+   */
+  size_t Poll();
+
+  /** Submit the queued requests and block until all requests have completed. */
+  void Wait();
+
+  /** @return whether requests go through io_uring rather than pread/pwrite */
+  inline bool IsUringEnabled() const { return ring_fd_ >= 0; }
+
+  inline size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return number of requests queued or submitted whose callback has not run yet */
+  inline size_t GetPendingCount() const { return num_queued_ + num_in_flight_; }
+
+ private:
+  struct Request {
+    char *data_{nullptr};
+    int64_t offset_{0};  // in the file
+    bool is_read_{false};
+    IOCallback callback_;
+  };
+
+  bool SetupRing();
+
+  void TeardownRing();
+
+  void Enqueue(page_id_t logical_page_id, char *page_data, bool is_read, IOCallback callback);
+
+  /** Reap completions, waiting for at least min_complete of them. */
+  size_t Reap(unsigned min_complete);
+
+  void Complete(uint32_t slot, int result);
+
+ private:
+  DiskManager *disk_manager_;
+  size_t queue_depth_;
+  std::vector<Request> requests_;    // indexed by the slot carried in user_data
+  std::vector<uint32_t> free_slots_;
+  size_t num_queued_{0};             // in the submission queue, not yet seen by the kernel
+  size_t num_in_flight_{0};          // submitted, completion not reaped yet
+  int ring_fd_{-1};
+  // submission and completion rings shared with the kernel
+  void *sq_ring_{nullptr};
+  void *cq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  uint32_t *sq_head_{nullptr};
+  uint32_t *sq_tail_{nullptr};
+  uint32_t sq_mask_{0};
+  uint32_t *sq_array_{nullptr};
+  uint32_t *cq_head_{nullptr};
+  uint32_t *cq_tail_{nullptr};
+  uint32_t cq_mask_{0};
+  void *cqes_{nullptr};
+};
+
+#endif  // MINISQL_ASYNC_IO_H
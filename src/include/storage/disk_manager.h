@@ -2,15 +2,22 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +26,22 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * One meta page counts M = DiskFileMetaPage::EXTENTS_PER_META_PAGE extents, the next M extents are preceded by a meta
+ * page of their own:
+ *      | Page MN | Meta Page 2 | Free Page BitMap M+1 | Page MN+1 | ... |
+ * Every meta page sits at a fixed position, so mapping a page id stays O(1). Physical page ids and file offsets are
+ * 64-bit, the logical page ids are only limited by page_id_t.
  */
 class DiskManager {
+  friend class AsyncIO;
+
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param preallocate_extents reserve the blocks of a new extent on disk at once with fallocate, instead of leaving
+   * it sparse until its pages are written
+   */
+  explicit DiskManager(const std::string &db_file, bool preallocate_extents = false);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,6 +61,12 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Create a queue keeping up to queue_depth page I/Os in flight, to be driven by a single thread.
+   * @param use_io_uring false forces the pread/pwrite fallback
+   */
+  std::unique_ptr<AsyncIO> CreateAsyncIO(size_t queue_depth = DEFAULT_IO_QUEUE_DEPTH, bool use_io_uring = true);
+
   /**
    * Get next free page from disk
    * @return logical page id of allocated page
@@ -58,6 +83,97 @@ class DiskManager {
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Map the db file read-only, so that clean pages can be read in place through GetMappedPage. The mapping grows with
+   * the file as extents are added.
+   * @return false if the file cannot be mapped
+   */
+  bool EnableMappedReads();
+
+  /**
+   * @return address of a page in the read-only mapping of the db file, nullptr if the page is not mapped
+   */
+  char *GetMappedPage(page_id_t logical_page_id);
+
+  /**
+   * Keep a CRC32C of every page in a side file next to the db file, named db_file.crc. Pages are stamped when written
+   * and checked when read, a page which does not match is logged and reported by GetCorruptPages. Pages written before
+   * checksums were first enabled carry no checksum and are not checked, pages read in place through GetMappedPage are
+   * only checked by the scrubber. Once the side file exists, checksums are enabled whenever the db file is opened.
+   *
+   * A page and its stamp reach the disk separately, Checkpoint syncs both. After a crash of the system, not just of
+   * the process, a page written since the last checkpoint may not match its stamp on disk and be reported although it
+   * is intact: rewriting it clears the report.
+   * @return false if the side file cannot be opened or mapped
+   */
+  bool EnableChecksums();
+
+  inline bool IsChecksumEnabled() const { return checksums_ != nullptr; }
+
+  /**
+   * Read and write the db file with O_DIRECT, bypassing the page cache of the kernel so that the buffer pool holds the
+   * only cached copy of a page. Transfers need buffers aligned to DIRECT_IO_ALIGNMENT: the frames of the buffer pool
+   * and the meta and bitmap pages cached here are, any other buffer is copied through an aligned one. Cannot be
+   * combined with mapped reads, which go through the page cache, and leaves the side files of the compressed page store
+   * buffered.
+   * @return false if the file system does not support O_DIRECT or the file is mapped
+   */
+  bool EnableDirectIO();
+
+  inline bool IsDirectIOEnabled() const { return direct_io_.load(std::memory_order_relaxed); }
+
+  /** @return whether a buffer can be handed to an O_DIRECT transfer as it is */
+  static inline bool IsDirectIOAligned(const char *page_data) {
+    return reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+
+  /**
+   * Store the pages compressed with LZ4 in two side files next to the db file. db_file.cdat holds the compressed
+   * images in runs of whole sectors, db_file.cmap maps every logical page to its run. A page is written to a new run,
+   * its old run is freed once the map points to the new one. Pages without a run are read from the db file, so an
+   * existing database can be compressed as its pages are written back. Once enabled, compression is enabled again by
+   * every later open of the file. Meta and bitmap pages are never compressed, compressed pages are never mapped.
+   * @return false if the side files cannot be opened or mapped
+   */
+  bool EnableCompression();
+
+  inline bool IsCompressionEnabled() const { return compressed_map_ != nullptr; }
+
+  /** @return bytes taken by the runs of the compressed pages in db_file.cdat */
+  uint64_t GetCompressedBytes();
+
+  /**
+   * Remove a db file together with its side files.
+   */
+  static void RemoveFiles(const std::string &db_file);
+
+  /**
+   * @return whether file_name is one of the side files DiskManager keeps next to a db file
+   */
+  static bool IsSideFile(const std::string &file_name);
+
+  /**
+   * Start a low priority thread which keeps walking the allocated pages, visiting pages_per_step of them and then
+   * sleeping for pause. Does nothing if checksums are off or the scrubber is already running.
+   */
+  void StartScrubber(std::chrono::milliseconds pause, size_t pages_per_step = DEFAULT_SCRUB_BATCH);
+
+  /** Stop the scrubber and wait for it to finish its current step. */
+  void StopScrubber();
+
+  /** @return logical ids of the pages found not to match their checksum, by reads or by the scrubber */
+  std::vector<page_id_t> GetCorruptPages();
+
+  /** @return number of allocated pages the scrubber has verified */
+  inline uint64_t GetScrubbedPageCount() const { return num_scrubbed_pages_; }
+
+  /**
+   * Write the cached meta page and the bitmap pages changed since the last checkpoint back to the file. With checksums
+   * on and pages stamped since the last checkpoint, the file and then the checksums are synced to disk, without
+   * holding up page allocation.
+   */
+  void Checkpoint();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
@@ -67,39 +183,183 @@ class DiskManager {
    * Get Meta Page
    * Note: Used only for debug
    */
-  char *GetMetaData() { return meta_data_; }
+  char *GetMetaData() { return meta_pages_[0]->data_; }
 
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  static constexpr uint32_t MAX_EXTENTS = MAX_VALID_PAGE_ID / BITMAP_SIZE + 1;
+  static constexpr int SECTOR_SIZE = 512;  // allocation unit of the compressed pages
+  static constexpr int DIRECT_IO_ALIGNMENT = PAGE_SIZE;  // covers the logical block size of any device
 
  private:
   /**
    * Helper function to get disk file size
    */
-  int GetFileSize(const std::string &file_name);
+  static int64_t GetFileSize(const std::string &file_name);
 
   /**
    * Read physical page from disk
+   * @return false if the page does not match its checksum
    */
-  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
+  bool ReadPhysicalPage(int64_t physical_page_id, char *page_data);
 
   /**
    * Write data to physical page in disk
    */
-  void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
+  void WritePhysicalPage(int64_t physical_page_id, const char *page_data);
+
+  /**
+   * Grow the file to cover every page of an extent without writing them, unwritten pages read as zeros
+   */
+  void ReserveExtent(uint32_t extent_index);
+
+  /**
+   * Read a logical page from its compressed run if it has one, from its physical page otherwise
+   * @return false if the page cannot be decompressed or does not match its checksum
+   */
+  bool ReadLogicalPage(page_id_t logical_page_id, char *page_data);
+
+  void WriteCompressedPage(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * @return map entry of a compressed page, 0 if the page has no run
+   */
+  uint64_t GetCompressedEntry(page_id_t logical_page_id);
+
+  /**
+   * Point the map entry of a page to a new run, or to none if entry is 0, and free its old run
+   */
+  void SetCompressedEntry(page_id_t logical_page_id, uint64_t entry);
+
+  /**
+   * Find num_sectors free sectors in a row in db_file.cdat, compress_latch_ must be held
+   */
+  uint64_t AllocateSectors(uint32_t num_sectors);
+
+  /**
+   * Map [from, to) of a side file at base + from, growing the file to at least to bytes first
+   */
+  bool MapSideFile(int fd, char *base, int64_t from, int64_t to);
+
+  /**
+   * Record the checksum of a page which has just been written
+   */
+  void StampChecksum(int64_t physical_page_id, const char *page_data);
+
+  /**
+   * @return false if a checksum is recorded for the page and page_data does not match it
+   */
+  bool MatchesChecksum(int64_t physical_page_id, const char *page_data);
+
+  /**
+   * Extend the side file and its mapping to hold the checksums of num_pages physical pages
+   */
+  void GrowChecksums(int64_t num_pages);
+
+  void ReportCorruptPage(page_id_t logical_page_id);
+
+  void Scrub(std::chrono::milliseconds pause, size_t pages_per_step);
+
+  /**
+   * Extend the mapping of the file up to end bytes
+   */
+  void GrowMapping(int64_t end);
+
+  /**
+   * Record that the file now reaches at least end bytes
+   */
+  void ExtendFileSize(int64_t end);
 
   /**
    * Map logical page id to physical page id
    */
-  page_id_t MapPageId(page_id_t logical_page_id);
+  int64_t MapPageId(page_id_t logical_page_id);
+
+  /**
+   * Physical page id of the meta page counting the extents of group meta_index
+   */
+  static int64_t MapMetaPageId(uint32_t meta_index) {
+    return META_PAGE_ID + static_cast<int64_t>(meta_index) * (1 + EXTENTS_PER_META_PAGE * (1 + BITMAP_SIZE));
+  }
+
+  /**
+   * Physical page id of the bitmap page of an extent
+   */
+  static int64_t MapBitmapPageId(uint32_t extent_index) {
+    return MapMetaPageId(extent_index / EXTENTS_PER_META_PAGE) + 1 +
+           static_cast<int64_t>(extent_index % EXTENTS_PER_META_PAGE) * (1 + BITMAP_SIZE);
+  }
+
+  /**
+   * Cached meta page counting the used pages of an extent, the first meta page holds the totals
+   */
+  DiskFileMetaPage *GetMetaPage(uint32_t meta_index) {
+    return reinterpret_cast<DiskFileMetaPage *>(meta_pages_[meta_index]->data_);
+  }
+
+  /**
+   * Counter of the used pages of an extent, in the meta page responsible for it
+   */
+  uint32_t &ExtentUsedPage(uint32_t extent_index) {
+    return GetMetaPage(extent_index / EXTENTS_PER_META_PAGE)->extent_used_page_[extent_index % EXTENTS_PER_META_PAGE];
+  }
+
+  static constexpr uint32_t EXTENTS_PER_META_PAGE = DiskFileMetaPage::EXTENTS_PER_META_PAGE;
+
+  /** The cached meta and bitmap pages are aligned so that they can be written with O_DIRECT as they are. */
+  struct alignas(DIRECT_IO_ALIGNMENT) MetaPageImage {
+    char data_[PAGE_SIZE]{};
+  };
+
+  struct alignas(DIRECT_IO_ALIGNMENT) BitmapPageImage : BitmapPage<PAGE_SIZE> {};
 
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // positional I/O on this descriptor has no shared cursor, so page reads and writes need no latch
+  int db_fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // size of the db file, grown by WritePhysicalPage instead of asking the file system on every read
+  std::atomic<int64_t> file_size_{0};
+  // protects the meta page and the bitmap pages
   std::recursive_mutex db_io_latch_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  bool preallocate_extents_;
+  // db_fd_ is open with O_DIRECT
+  std::atomic<bool> direct_io_{false};
+  // the meta pages and the bitmap pages are only read at open and written back by Checkpoint
+  std::vector<std::unique_ptr<MetaPageImage>> meta_pages_;
+  std::vector<bool> meta_dirty_;
+  std::vector<std::unique_ptr<BitmapPageImage>> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  // extents which still have a free page, allocation takes the lowest one
+  std::set<uint32_t> free_extents_;
+  // read-only mapping of the file, placed in a fixed address range reserved up front so that it never moves
+  static constexpr int64_t MAPPING_RESERVE = int64_t{1} << 40;
+  char *mapping_{nullptr};
+  std::atomic<int64_t> mapped_size_{0};
+  // checksums of the physical pages, 0 if unknown, in a mapping of the side file which grows like the one above
+  static constexpr int64_t CHECKSUM_RESERVE = int64_t{1} << 34;
+  static constexpr int64_t CHECKSUM_CHUNK = int64_t{1} << 20;  // the side file grows by this many bytes at a time
+  int crc_fd_{-1};
+  uint32_t *checksums_{nullptr};
+  std::atomic<int64_t> num_checksums_{0};
+  std::atomic<bool> checksums_dirty_{false};  // pages were stamped since the last Checkpoint synced the side file
+  std::mutex checksum_latch_;           // protects the growth of the side file and corrupt_pages_
+  std::set<page_id_t> corrupt_pages_;
+  std::thread scrubber_;
+  std::mutex scrubber_latch_;
+  std::condition_variable scrubber_cv_;
+  bool stop_scrubber_{false};
+  std::atomic<uint64_t> num_scrubbed_pages_{0};
+  // compressed pages, the map is an array of entries indexed by logical page id mapped like the checksums
+  static constexpr int64_t COMPRESSED_MAP_RESERVE = int64_t{1} << 34;
+  static constexpr uint32_t MAX_RUN_SECTORS = PAGE_SIZE / SECTOR_SIZE;
+  int cmap_fd_{-1};
+  int cdat_fd_{-1};
+  uint64_t *compressed_map_{nullptr};
+  std::atomic<int64_t> num_compressed_entries_{0};
+  std::mutex compress_latch_;                             // protects the map growth and the sector allocation
+  std::vector<uint64_t> free_runs_[MAX_RUN_SECTORS + 1];  // free runs of db_file.cdat by length in sectors
+  uint64_t num_sectors_{0};                               // end of db_file.cdat in sectors
+  uint64_t num_used_sectors_{0};
   // by zat: 1. PAGE_SIZE为一页总的大小 2. meta_data_如[1.3]所说需要转换为disk_file_meta_page，可以从头文件进去看定义
 };
 
@@ -0,0 +1,79 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap records, for every page of a table heap, a coarse category of the free space the page has, so that an
+ * insert goes straight to a page with room instead of trying the pages of the heap one after the other.
+ *
+ * The map is kept in a chain of FreeSpaceMapPages, in the order the heap pages were added, and mirrored in memory by
+ * a max tree over the categories, which finds the first page with room in O(log n). The categories are hints: a
+ * category is only updated when the caller reports the free space of a page, so a page may have more room than its
+ * category says, and the caller must cope with a page having less.
+ */
+class FreeSpaceMap {
+ public:
+  /** Create an empty map, whose first page is allocated right away. */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  /** Load the map whose first page is root_page_id. */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t root_page_id);
+
+  /**
+   * @param size bytes an insert needs on a page, its slot included
+   * @return the last page added if its category fits, else the first page whose category fits, INVALID_PAGE_ID if
+   * none does
+   */
+  page_id_t FindPage(uint32_t size);
+
+  /** Record a new page of the heap with free_space bytes free, it becomes the last page. */
+  void AddPage(page_id_t page_id, uint32_t free_space);
+
+  /** Record that page_id now has free_space bytes free, the map page is only written if the category changes. */
+  void UpdatePage(page_id_t page_id, uint32_t free_space);
+
+  /** Delete the pages of the map, which must not be used afterwards. */
+  void Destroy();
+
+  inline page_id_t GetRootPageId() const { return root_page_id_; }
+
+  /** @return the page added last, INVALID_PAGE_ID if the map is empty */
+  page_id_t GetLastPageId();
+
+  /** @return number of heap pages recorded */
+  size_t GetPageCount();
+
+  /** @return the category of free_space, rounded down */
+  static inline uint8_t ToCategory(uint32_t free_space) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / FreeSpaceMapPage::CATEGORY_SIZE, UINT8_MAX));
+  }
+
+ private:
+  /** @return the category a page must have to surely hold size bytes, rounded up */
+  static inline uint32_t RequiredCategory(uint32_t size) {
+    return (size + FreeSpaceMapPage::CATEGORY_SIZE - 1) / FreeSpaceMapPage::CATEGORY_SIZE;
+  }
+
+  /** Set the category of the entry at index in the tree, growing the tree if needed. latch_ must be held. */
+  void SetTreeCategory(size_t index, uint8_t category);
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::mutex latch_;
+  std::vector<page_id_t> map_pages_;                  // the chain of map pages
+  std::vector<page_id_t> heap_pages_;                 // the heap page of each entry
+  std::unordered_map<page_id_t, size_t> entries_;     // heap page id -> entry index
+  size_t capacity_{1};                                // leaves of the tree, a power of two
+  std::vector<uint8_t> tree_;                         // max tree, node i has children 2i and 2i+1, leaves from capacity_
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
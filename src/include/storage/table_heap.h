@@ -1,11 +1,16 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
 
 class TableHeap {
@@ -17,21 +22,53 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * Open an existing heap.
+   * @param fsm_page_id root of the free space map of the heap, see GetFreeSpaceMapPageId. A heap opened without it, as
+   * one written before heaps had a map, gets a new map built by walking its pages.
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           page_id_t fsm_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, fsm_page_id);
   }
 
   ~TableHeap() {}
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * The page is picked through the free space map, a new page is appended when no page has room.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Txn *txn);
 
+  /**
+   * Insert the rows of [first, last) in one pass. The rows are serialized straight into the last page of the table
+   * while it has room, then into new pages chained as they are allocated, each page is fetched once. Neither the free
+   * space map is searched nor are indexes updated.
+   * @param[in] first, last Range of the rows to insert, the rid of each row is set like by InsertTuple
+   * @param[out] rids Rids of the inserted rows in order, may be null
+   * @return true iff all the rows were inserted, the rows before the first failing one stay inserted
+   */
+  template <typename RowIterator>
+  bool BulkInsert(RowIterator first, RowIterator last, std::vector<RowId> *rids, Txn *txn) {
+    std::lock_guard<std::mutex> append_guard(append_latch_);
+    PageGuard page_guard;
+    bool success = true;
+    for (; first != last; ++first) {
+      Row &row = *first;
+      if (!BulkAppend(row, &page_guard, txn)) {
+        success = false;
+        break;
+      }
+      if (rids != nullptr) rids->push_back(row.GetRowId());
+    }
+    FinishBulkPage(&page_guard);
+    return success;
+  }
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -75,12 +112,14 @@ class TableHeap {
     auto next_page_id = first_page_id_;
     while (next_page_id != INVALID_PAGE_ID) {
       auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
+      {
+        PageGuard guard = buffer_pool_manager_->FetchPageGuarded(old_page_id);
+        assert(guard.IsValid());
+        next_page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+      }
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    free_space_map_->Destroy();
   }
 
   /**
@@ -89,9 +128,12 @@ class TableHeap {
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param strategy ring of frames the scan recycles, null to read through the shared buffer pool
+   * @param filter tuples the iterator stops at, null for all of them
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr,
+                      TableIterator::RowFilter filter = nullptr);
 
   /**
    * @return the end iterator of this table
@@ -103,6 +145,17 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the root page of the free space map, which the owner of the heap keeps along with the first page id to
+   * reopen the heap, see TableMetadata
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_->GetRootPageId(); }
+
+  /**
+   * @return the number of pages of this table
+   */
+  inline size_t GetPageCount() const { return free_space_map_->GetPageCount(); }
+
  private:
   /**
    * create table heap and initialize first page
@@ -123,20 +176,47 @@ class TableHeap {
 
     table_page->Init(new_page_id, INVALID_PAGE_ID, log_manager_, txn);
 
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+    free_space_map_->AddPage(new_page_id, table_page->GetFreeSpaceRemaining());
+
     buffer_pool_manager_->UnpinPage(new_page_id, /*is_dirty=*/true);
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t fsm_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    OpenFreeSpaceMap(fsm_page_id);
+  }
+
+  /**
+   * Insert a tuple into the last page, or into a new page appended to the chain if it has no room.
+   */
+  bool AppendTuple(Row &row, Txn *txn);
+
+  /**
+   * Insert a row for BulkInsert into the page held by page_guard, which starts out empty, moving the guard on to a new
+   * page when the row does not fit. append_latch_ must be held.
+   */
+  bool BulkAppend(Row &row, PageGuard *page_guard, Txn *txn);
+
+  /** Report the free space left on the page held by page_guard to the free space map and unpin it. */
+  void FinishBulkPage(PageGuard *page_guard);
+
+  /**
+   * Load the free space map whose root is fsm_page_id, or build one by walking the page chain if it is
+   * INVALID_PAGE_ID.
+   */
+  void OpenFreeSpaceMap(page_id_t fsm_page_id);
 
  private:
   BufferPoolManager *buffer_pool_manager_;
   page_id_t first_page_id_;
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  std::mutex append_latch_;  // serializes appending pages to the chain
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
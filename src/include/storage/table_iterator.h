@@ -1,20 +1,38 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/page_guard.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
+#include "record/row_view.h"
 
 class TableHeap;
 
+/**
+ * TableIterator walks the tuples of a table heap. A row is only deserialized when it is dereferenced, and an iterator
+ * given a filter skips the tuples the filter rejects, evaluating it on a RowView of each tuple in place.
+ */
 class TableIterator {
 public:
+ /** Decides on a view of a tuple, taken under the read latch of its page, whether the iterator stops at it. */
+ using RowFilter = std::function<bool(const RowView &)>;
+
  // you may define your own constructor based on your member variables
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                        std::shared_ptr<BufferAccessStrategy> strategy = nullptr, RowFilter filter = nullptr);
  
  // 实现方便把这个的explicit删掉了，如果有问题再说 [by zat]
+ // a copy pins the current page once more, moving hands the pin over
  TableIterator(const TableIterator &other);
 
+ TableIterator(TableIterator &&other) noexcept = default;
+
   virtual ~TableIterator();
 
   bool operator==(const TableIterator &itr) const;
@@ -27,16 +45,46 @@ public:
 
   TableIterator &operator=(const TableIterator &itr) noexcept;
 
+  TableIterator &operator=(TableIterator &&itr) noexcept = default;
+
   TableIterator &operator++();
 
   TableIterator operator++(int);
 
+  /** @return the row id of the current tuple, without deserializing it */
+  inline RowId GetRowId() const { return current_rid_; }
+
+  /** Replace the fields of row with copies of the fields at columns of the current tuple, deserializing no others. */
+  void Materialize(const std::vector<uint32_t> &columns, Row *row);
+
 private:
+  /** Pin page_id for the iterator, through the rings of strategy_ if it has one. */
+  PageGuard FetchPage(page_id_t page_id);
+
+  /** Move current_rid_ to the next tuple of the heap, INVALID_ROWID past the last one. */
+  void Step();
+
+  /** Step on until the filter accepts the current tuple. */
+  void SkipRejected();
+
+  /** @return whether the filter, if any, accepts the tuple at current_rid_ */
+  bool Accept();
+
+  /** Load current_row_ from the tuple at current_rid_, on the page held by page_guard_. */
+  void LoadCurrentRow();
+
   // add your own private member variables here
   TableHeap *table_heap_;
   Txn       *txn_;
   Row       current_row_;
+  bool      row_loaded_{false};  // whether current_row_ holds the tuple at current_rid_
   RowId     current_rid_;
+  RowFilter filter_;
+  RowView   view_;
+  // shared by the copies of a scan, null for a plain iterator
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  // pins the page of current_rid_ between two steps, empty at the end
+  PageGuard page_guard_;
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
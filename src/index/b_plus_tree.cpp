@@ -37,15 +37,18 @@ void BPlusTree::Destroy(page_id_t current_page_id) {
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(2);
   }
-  auto page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(current_page_id)->GetData());
-  if (!page->IsLeafPage()) {
-    auto internal = reinterpret_cast<InternalPage *>(page);
-    for (int i = 0; i < internal->GetSize(); i++) {
-      Destroy(internal->ValueAt(i));
+  {
+    PageGuard guard = buffer_pool_manager_->FetchPageGuarded(current_page_id);
+    auto page = guard.As<BPlusTreePage>();
+    if (!page->IsLeafPage()) {
+      auto internal = reinterpret_cast<InternalPage *>(page);
+      for (int i = 0; i < internal->GetSize(); i++) {
+        Destroy(internal->ValueAt(i));
+      }
     }
   }
+  // a page can only be deleted once its last pin is gone
   buffer_pool_manager_->DeletePage(current_page_id);
-  buffer_pool_manager_->UnpinPage(current_page_id, false);
 }
 
 
@@ -515,7 +518,8 @@ IndexIterator BPlusTree::End() {
 
 Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
   if (page_id == INVALID_PAGE_ID) page_id = root_page_id_;
-  auto page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+  Page *raw_page = buffer_pool_manager_->FetchPage(page_id);
+  auto page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
   while (!page->IsLeafPage()) {
     auto internal = reinterpret_cast<InternalPage *>(page);
     page_id_t child_page_id;
@@ -524,11 +528,12 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
     } else {
       child_page_id = internal->Lookup(key, processor_);
     }
-    auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(child_page_id)->GetData());
+    Page *child_raw_page = buffer_pool_manager_->FetchPage(child_page_id);
     buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    page = child_page;
+    raw_page = child_raw_page;
+    page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
   }
-  return reinterpret_cast<Page *>(page);
+  return raw_page;
 }
 
 
@@ -1,20 +1,49 @@
 #include "index/index_iterator.h"
 
+#include <utility>
+
 #include "index/basic_comparator.h"
 #include "index/generic_key.h"
 
+static page_id_t NextLeafPageId(Page *page) {
+  return reinterpret_cast<BPlusTreeLeafPage *>(page->GetData())->GetNextPageId();
+}
+
 IndexIterator::IndexIterator() = default;
 
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  page_guard = buffer_pool_manager->FetchPageGuardedForRead(current_page_id);
+  page = page_guard.As<LeafPage>();
+  buffer_pool_manager->PrefetchChain(page->GetNextPageId(), NextLeafPageId);
 }
 
-IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
-    buffer_pool_manager->UnpinPage(current_page_id, false);
+IndexIterator::IndexIterator(IndexIterator &&that) noexcept
+    : current_page_id(that.current_page_id),
+      page(that.page),
+      item_index(that.item_index),
+      buffer_pool_manager(that.buffer_pool_manager),
+      page_guard(std::move(that.page_guard)) {
+  that.current_page_id = INVALID_PAGE_ID;
+  that.page = nullptr;
+  that.item_index = 0;
 }
 
+IndexIterator &IndexIterator::operator=(IndexIterator &&that) noexcept {
+  if (this == &that) return *this;
+  current_page_id = that.current_page_id;
+  page = that.page;
+  item_index = that.item_index;
+  buffer_pool_manager = that.buffer_pool_manager;
+  page_guard = std::move(that.page_guard);
+  that.current_page_id = INVALID_PAGE_ID;
+  that.page = nullptr;
+  that.item_index = 0;
+  return *this;
+}
+
+IndexIterator::~IndexIterator() = default;
+
 std::pair<GenericKey *, RowId> IndexIterator::operator*() {
   return page->GetItem(item_index);
 }
@@ -29,28 +58,20 @@ IndexIterator &IndexIterator::operator++() {
 
     // If there is a next page
     if (next_page_id != INVALID_PAGE_ID) {
-      // Unpin the current page
-      buffer_pool_manager->UnpinPage(current_page_id, false);
-
-      // Move to the next page
+      // Move to the next page, the guard unpins the current one
       current_page_id = next_page_id;
-      auto *next_page = buffer_pool_manager->FetchPage(next_page_id);
+      page_guard = buffer_pool_manager->FetchPageGuardedForRead(next_page_id);
 
       // If the next page is not null
-      if (next_page != nullptr) {
-        // Cast the data to a LeafPage pointer
-        auto *next_leaf_page = reinterpret_cast<LeafPage *>(next_page->GetData());
-
+      if (page_guard.IsValid()) {
         // Update the page pointer and reset the item index
-        page = next_leaf_page;
+        page = page_guard.As<LeafPage>();
         item_index = 0;
+        // Keep the leaves after this one in flight
+        buffer_pool_manager->PrefetchChain(page->GetNextPageId(), NextLeafPageId);
       }
     } else {
       // If there is no next page, set the iterator to its default state
-      buffer_pool_manager->UnpinPage(current_page_id, false);
-      current_page_id = INVALID_PAGE_ID;
-      page = nullptr;
-      item_index = 0;
       *this = IndexIterator();
     }
   }
@@ -41,6 +41,22 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *loc
   return true;
 }
 
+bool TablePage::AppendTuple(Row &row, uint32_t serialized_size, Schema *schema) {
+  ASSERT(serialized_size > 0, "Can not have empty row.");
+  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+    return false;
+  }
+  uint32_t i = GetTupleCount();
+  SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
+  uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(GetData() + GetFreeSpacePointer(), schema);
+  ASSERT(write_bytes == serialized_size, "Unexpected behavior in row serialize.");
+  SetTupleOffsetAtSlot(i, GetFreeSpacePointer());
+  SetTupleSize(i, serialized_size);
+  row.SetRowId(RowId(GetTablePageId(), i));
+  SetTupleCount(i + 1);
+  return true;
+}
+
 bool TablePage::MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort.
@@ -161,6 +177,15 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+bool TablePage::GetTupleView(const RowId &rid, Schema *schema, RowView *view) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    return false;
+  }
+  view->Reset(GetData() + GetTupleOffsetAtSlot(slot_num), schema, rid);
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -171,6 +171,10 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeSet:
+      return "kNodeSet";
+    case kNodeLoadData:
+      return "kNodeLoadData";
     default:
       return "error type";
   }
@@ -0,0 +1,127 @@
+#include "record/csv_reader.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+size_t CsvReader::ReadRows(std::vector<Row> *rows, size_t max_rows) {
+  if (!error_.empty()) return 0;
+  std::string line;
+  std::vector<std::string> cells;
+  std::vector<bool> quoted;
+  std::vector<Field> fields;
+  size_t count = 0;
+  while (count < max_rows && std::getline(in_, line)) {
+    line_no_++;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+    if (!SplitLine(line, &cells, &quoted) || !ParseCells(cells, quoted, &fields)) {
+      error_ = "line " + std::to_string(line_no_) + ": " + error_;
+      break;
+    }
+    rows->emplace_back(fields);
+    count++;
+  }
+  return count;
+}
+
+bool CsvReader::SplitLine(const std::string &line, std::vector<std::string> *cells, std::vector<bool> *quoted) {
+  cells->clear();
+  quoted->clear();
+  size_t pos = 0;
+  while (true) {
+    std::string cell;
+    bool is_quoted = pos < line.size() && line[pos] == '"';
+    if (is_quoted) {
+      for (pos++;; pos++) {
+        if (pos >= line.size()) {
+          error_ = "unterminated quoted cell";
+          return false;
+        }
+        if (line[pos] == '"') {
+          if (pos + 1 < line.size() && line[pos + 1] == '"') {
+            cell.push_back('"');
+            pos++;
+          } else {
+            pos++;
+            break;
+          }
+        } else {
+          cell.push_back(line[pos]);
+        }
+      }
+      if (pos < line.size() && line[pos] != ',') {
+        error_ = "unexpected character after quoted cell";
+        return false;
+      }
+    } else {
+      size_t end = line.find(',', pos);
+      if (end == std::string::npos) end = line.size();
+      cell = line.substr(pos, end - pos);
+      pos = end;
+    }
+    cells->push_back(std::move(cell));
+    quoted->push_back(is_quoted);
+    if (pos >= line.size()) break;
+    pos++;  // skip the comma
+  }
+  return true;
+}
+
+bool CsvReader::ParseCells(const std::vector<std::string> &cells, const std::vector<bool> &quoted,
+                           std::vector<Field> *fields) {
+  if (cells.size() != schema_->GetColumnCount()) {
+    error_ = "expected " + std::to_string(schema_->GetColumnCount()) + " cells, got " + std::to_string(cells.size());
+    return false;
+  }
+  fields->clear();
+  fields->reserve(cells.size());
+  for (uint32_t i = 0; i < cells.size(); i++) {
+    const Column *column = schema_->GetColumn(i);
+    const std::string &cell = cells[i];
+    if (cell.empty() && !quoted[i]) {
+      if (!column->IsNullable()) {
+        error_ = "column " + column->GetName() + " can not be null";
+        return false;
+      }
+      fields->emplace_back(column->GetType());
+      continue;
+    }
+    char *end = nullptr;
+    errno = 0;
+    switch (column->GetType()) {
+      case TypeId::kTypeInt: {
+        long value = std::strtol(cell.c_str(), &end, 10);
+        if (end == cell.c_str() || *end != '\0' || errno != 0 || value < INT32_MIN || value > INT32_MAX) {
+          error_ = "invalid int " + cell + " for column " + column->GetName();
+          return false;
+        }
+        fields->emplace_back(TypeId::kTypeInt, static_cast<int32_t>(value));
+        break;
+      }
+      case TypeId::kTypeFloat: {
+        float value = std::strtof(cell.c_str(), &end);
+        if (end == cell.c_str() || *end != '\0' || errno != 0) {
+          error_ = "invalid float " + cell + " for column " + column->GetName();
+          return false;
+        }
+        fields->emplace_back(TypeId::kTypeFloat, value);
+        break;
+      }
+      case TypeId::kTypeChar: {
+        if (cell.size() > column->GetLength()) {
+          error_ = "value too long for column " + column->GetName();
+          return false;
+        }
+        fields->emplace_back(TypeId::kTypeChar, const_cast<char *>(cell.data()), static_cast<uint32_t>(cell.size()),
+                             true);
+        break;
+      }
+      default:
+        error_ = "column " + column->GetName() + " has an invalid type";
+        return false;
+    }
+  }
+  return true;
+}
@@ -1,102 +1,86 @@
 #include "record/row.h"
+
+#include "record/row_view.h"
+
 /**
- *  Row format:
- * -------------------------------------------
- * | Header | Field-1 | ... | Field-N |
- * -------------------------------------------
- *  Header format:
- * --------------------------------------------
- * | Field Nums | Null bitmap |
- * -------------------------------------------
- *
- *  std::vector<Field *> fields_; 
- */
-/**
- * Zat Implement
+ * See row.h for the formats.
  */
 uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
-  // 会不会是因为size开大了一点点
   ASSERT(schema->GetColumnCount() <= fields_.size(), "Fields size do not match schema's column size.");
-  
-  uint32_t offset = 0, 
-           field_count = schema->GetColumnCount(),
-           bitmap_bytes_count = (field_count + 7)/8;
-  // bitmap_bytes_count 的 +7 是为了上取整
+  const RowLayout &layout = schema->GetLayout();
+  uint32_t field_count = schema->GetColumnCount();
 
-  // column没有magic number，可能由于它不是meta data性质的
-  MACH_WRITE_UINT32(buf + offset, field_count);
-  offset += sizeof(uint32_t);
+  MACH_WRITE_UINT32(buf, RowLayout::MakeHeader(RowLayout::FORMAT_FIXED_FIRST, field_count));
+  char *null_bitmap = buf + layout.GetNullBitmapOffset();
+  memset(null_bitmap, 0, layout.GetNullBitmapSize());
 
-  // 现场生成bitmap
-  std::vector<uint8_t>null_bitmap(bitmap_bytes_count,0);
-  for(uint32_t i = 0; i < field_count; ++i) {
-    if(fields_[i]->IsNull())
-      null_bitmap[i/8] |= (1<<(i%8));
+  uint32_t var_end = layout.GetVarDataOffset();
+  for (uint32_t i = 0; i < field_count; ++i) {
+    const Field *field = fields_[i];
+    uint32_t slot = layout.GetSlotOffset(i);
+    if (field->IsNull()) {
+      null_bitmap[i / 8] |= (1 << (i % 8));
+    }
+    if (layout.IsFixed(i)) {
+      if (field->IsNull()) {
+        memset(buf + slot, 0, Type::GetTypeSize(schema->GetColumn(i)->GetType()));
+      } else {
+        layout.GetSerializeKernel(i)(*field, buf + slot);
+      }
+    } else {
+      if (!field->IsNull()) {
+        uint32_t len = FieldKernels<TypeId::kTypeChar>::GetLength(*field);
+        memcpy(buf + var_end, FieldKernels<TypeId::kTypeChar>::GetData(*field), len);
+        var_end += len;
+      }
+      MACH_WRITE_UINT32(buf + slot, var_end);
+    }
   }
-  // 写没有现成的，抄string的版本
-  memcpy(buf + offset, null_bitmap.data(), bitmap_bytes_count);
-  offset += bitmap_bytes_count;
-
-  for(uint32_t i = 0; i < field_count; ++i) {
-    if(fields_[i]->IsNull()) continue;
-    uint32_t sz = fields_[i]->SerializeTo(buf + offset);
-    offset += sz;    
-  }
-  
-   uint32_t written_count = MACH_READ_UINT32(buf);
-   LOG(INFO) << "Serialized field_count = " << written_count;
-
-  return offset;
+  return var_end;
 }
 
 uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
   ASSERT(schema != nullptr, "Invalid schema before deserialize.");
   ASSERT(fields_.empty(), "Non empty field in row.");
-
-  uint32_t offset = 0;
-  uint32_t field_count = MACH_READ_UINT32(buf+offset);
-  offset += sizeof(uint32_t);
-
-   LOG(INFO) << "Deserialized field_count = " << field_count
-           << ", schema columns = " << schema->GetColumnCount();
-
-  ASSERT(field_count == schema->GetColumnCount(), "Schema and data field count mismatch.");
-
-  uint32_t bitmap_bytes_count = (field_count + 7) / 8;
-  std::vector<uint8_t>null_bitmap(bitmap_bytes_count);
-  memcpy(null_bitmap.data(), buf + offset, bitmap_bytes_count);
-  offset += bitmap_bytes_count;
-
-  for(uint32_t i = 0; i < field_count; ++i) {
-    bool is_null = (null_bitmap[i/8]>>(i%8))&1;
-    Field *field = nullptr;
-    uint32_t sz = 0;
-    sz = Field::DeserializeFrom(buf + offset, schema->GetColumn(i)->GetType(), &field, is_null);
-    offset += sz;    
-    fields_.push_back(field);
+  RowView view(buf, schema, rid_);
+  fields_.reserve(view.GetFieldCount());
+  for (uint32_t i = 0; i < view.GetFieldCount(); ++i) {
+    AppendField(view.GetField(i));
   }
-
-  return offset;
+  return view.GetSerializedSize();
 }
 
 uint32_t Row::GetSerializedSize(Schema *schema) const {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
   ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
-  
-  uint32_t offset = 0, 
-  field_count = schema->GetColumnCount(),
-  bitmap_bytes_count = (field_count + 7)/8;
-  offset += sizeof(uint32_t);
-  offset += bitmap_bytes_count;
-
-  for(uint32_t i = 0; i < field_count; ++i) {
-    if(fields_[i]->IsNull()) continue;
-    uint32_t sz = fields_[i]->GetSerializedSize();
-    offset += sz;    
+  const RowLayout &layout = schema->GetLayout();
+  uint32_t size = layout.GetVarDataOffset();
+  for (uint32_t i = 0; i < schema->GetColumnCount(); ++i) {
+    if (!layout.IsFixed(i) && !fields_[i]->IsNull()) {
+      size += FieldKernels<TypeId::kTypeChar>::GetLength(*fields_[i]);
+    }
   }
+  return size;
+}
 
-  return offset;
+void Row::AppendField(const Field &field) {
+  bool copy_chars = field.GetTypeId() == TypeId::kTypeChar && !field.IsNull();
+  if (arena_ == nullptr) {
+    if (copy_chars) {
+      fields_.push_back(new Field(TypeId::kTypeChar, const_cast<char *>(field.GetData()), field.GetLength(), true));
+    } else {
+      fields_.push_back(new Field(field));
+    }
+    return;
+  }
+  // the arena never runs destructors, so the field must not own its data
+  if (copy_chars) {
+    uint32_t len = field.GetLength();
+    fields_.push_back(arena_->New<Field>(TypeId::kTypeChar, arena_->CopyBytes(field.GetData(), len), len, false));
+  } else {
+    fields_.push_back(arena_->New<Field>(field));
+  }
 }
 
 void Row::GetKeyFromRow(const Schema *schema, const Schema *key_schema, Row &key_row) {
@@ -0,0 +1,26 @@
+#include "record/row_layout.h"
+
+RowLayout::RowLayout(const std::vector<Column *> &columns) {
+  slots_.reserve(columns.size());
+  uint32_t offset = sizeof(uint32_t) + (static_cast<uint32_t>(columns.size()) + 7) / 8;
+  uint32_t var_count = 0;
+  for (auto column : columns) {
+    if (column->GetType() == TypeId::kTypeChar) {
+      slots_.push_back({false, 0, 0, nullptr});
+      var_count++;
+    } else {
+      uint32_t size = Type::GetTypeSize(column->GetType());
+      slots_.push_back({true, offset, size, ::GetSerializeKernel(column->GetType())});
+      offset += size;
+    }
+  }
+  var_table_offset_ = offset;
+  for (auto &slot : slots_) {
+    if (!slot.fixed_) {
+      slot.offset_ = offset;
+      offset += sizeof(uint32_t);
+    }
+  }
+  var_data_offset_ = offset;
+  ASSERT(var_data_offset_ == var_table_offset_ + var_count * sizeof(uint32_t), "Unexpected var offset table size.");
+}
@@ -0,0 +1,91 @@
+#include "record/row_view.h"
+
+void RowView::Reset(const char *data, const Schema *schema, RowId rid) {
+  data_ = data;
+  schema_ = schema;
+  rid_ = rid;
+  field_count_ = RowLayout::GetFieldCount(data);
+  ASSERT(field_count_ == schema->GetColumnCount(), "Schema and data field count mismatch.");
+  null_bitmap_ = reinterpret_cast<const uint8_t *>(data + sizeof(uint32_t));
+  offsets_.clear();
+  if (RowLayout::GetFormat(data) == RowLayout::FORMAT_LEGACY) {
+    layout_ = nullptr;
+    offsets_.push_back(sizeof(uint32_t) + (field_count_ + 7) / 8);
+  } else {
+    ASSERT(RowLayout::GetFormat(data) == RowLayout::FORMAT_FIXED_FIRST, "Unknown row format.");
+    layout_ = &schema->GetLayout();
+  }
+}
+
+uint32_t RowView::GetLegacyOffset(uint32_t idx) const {
+  while (offsets_.size() <= idx) {
+    // the field after the last resolved one starts where that one ends
+    uint32_t last = offsets_.size() - 1;
+    uint32_t offset = offsets_.back();
+    if (!IsNull(last)) {
+      TypeId type = schema_->GetColumn(last)->GetType();
+      if (type == TypeId::kTypeChar) {
+        offset += sizeof(uint32_t) + MACH_READ_UINT32(data_ + offset);
+      } else {
+        offset += Type::GetTypeSize(type);
+      }
+    }
+    offsets_.push_back(offset);
+  }
+  return offsets_[idx];
+}
+
+const char *RowView::GetFieldData(uint32_t idx, uint32_t *len) const {
+  if (layout_ != nullptr) {
+    return data_ + layout_->GetFieldOffset(data_, idx, len);
+  }
+  const char *data = data_ + GetLegacyOffset(idx);
+  TypeId type = schema_->GetColumn(idx)->GetType();
+  if (type != TypeId::kTypeChar) {
+    *len = Type::GetTypeSize(type);
+    return data;
+  }
+  *len = MACH_READ_UINT32(data);
+  return data + sizeof(uint32_t);
+}
+
+Field RowView::GetField(uint32_t idx) const {
+  TypeId type = schema_->GetColumn(idx)->GetType();
+  if (IsNull(idx)) {
+    return Field(type);
+  }
+  uint32_t len;
+  const char *data = GetFieldData(idx, &len);
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, MACH_READ_FROM(int32_t, data));
+    case TypeId::kTypeFloat:
+      return Field(type, MACH_READ_FROM(float, data));
+    default:
+      return Field(type, const_cast<char *>(data), len, false);
+  }
+}
+
+uint32_t RowView::GetSerializedSize() const {
+  return layout_ != nullptr ? layout_->GetRowSize(data_) : GetLegacyOffset(field_count_);
+}
+
+void RowView::Materialize(Row *row) const {
+  row->destroy();
+  row->SetRowId(rid_);
+  auto &fields = row->GetFields();
+  fields.reserve(field_count_);
+  for (uint32_t i = 0; i < field_count_; i++) {
+    row->AppendField(GetField(i));
+  }
+}
+
+void RowView::Materialize(const std::vector<uint32_t> &columns, Row *row) const {
+  row->destroy();
+  row->SetRowId(rid_);
+  auto &fields = row->GetFields();
+  fields.reserve(columns.size());
+  for (uint32_t idx : columns) {
+    row->AppendField(GetField(idx));
+  }
+}
@@ -0,0 +1,241 @@
+#include "storage/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/macros.h"
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MINISQL_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+AsyncIO::AsyncIO(DiskManager *disk_manager, size_t queue_depth, bool use_io_uring)
+    : disk_manager_(disk_manager), queue_depth_(queue_depth) {
+  ASSERT(queue_depth_ > 0, "Invalid queue depth.");
+  requests_.resize(queue_depth_);
+  for (size_t i = queue_depth_; i > 0; i--) {
+    free_slots_.push_back(i - 1);
+  }
+  if (use_io_uring && !SetupRing()) {
+    LOG(WARNING) << "io_uring is not available, falling back to pread/pwrite";
+  }
+}
+
+AsyncIO::~AsyncIO() {
+  Wait();
+  TeardownRing();
+}
+
+void AsyncIO::SubmitRead(page_id_t logical_page_id, char *page_data, IOCallback callback) {
+  Enqueue(logical_page_id, page_data, true, std::move(callback));
+}
+
+void AsyncIO::SubmitWrite(page_id_t logical_page_id, const char *page_data, IOCallback callback) {
+  // the kernel only reads from the buffer of a write
+  Enqueue(logical_page_id, const_cast<char *>(page_data), false, std::move(callback));
+}
+
+void AsyncIO::Wait() {
+  while (GetPendingCount() > 0) {
+    Submit();
+    if (num_in_flight_ > 0) Reap(1);
+  }
+}
+
+size_t AsyncIO::Poll() {
+  return IsUringEnabled() ? Reap(0) : 0;
+}
+
+#ifdef MINISQL_HAVE_IO_URING
+
+bool AsyncIO::SetupRing() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_, &params));
+  if (fd < 0) return false;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    close(fd);
+    return false;
+  }
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  ring_fd_ = fd;
+  if (cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    if (cq_ring_ == MAP_FAILED) cq_ring_ = nullptr;
+    if (sqes_ == MAP_FAILED) sqes_ = nullptr;
+    TeardownRing();
+    return false;
+  }
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return true;
+}
+
+void AsyncIO::TeardownRing() {
+  if (ring_fd_ < 0) return;
+  if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+  ring_fd_ = -1;
+  sq_ring_ = cq_ring_ = sqes_ = nullptr;
+}
+
+/**
+ * This thread is the only producer of the submission ring, so the tail can be read plainly, it is published with a
+ * release store so that the kernel sees a complete entry.
+ */
+void AsyncIO::Enqueue(page_id_t logical_page_id, char *page_data, bool is_read, IOCallback callback) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  // compressed pages are not at a fixed offset of the db file, an unaligned buffer needs the copy ReadPage makes
+  if (!IsUringEnabled() || disk_manager_->IsCompressionEnabled() ||
+      (disk_manager_->IsDirectIOEnabled() && !DiskManager::IsDirectIOAligned(page_data))) {
+    if (is_read) {
+      disk_manager_->ReadPage(logical_page_id, page_data);
+    } else {
+      disk_manager_->WritePage(logical_page_id, page_data);
+    }
+    if (callback) callback(true);
+    return;
+  }
+  if (GetPendingCount() == queue_depth_) {
+    Submit();
+    Reap(1);
+  }
+  int64_t offset = disk_manager_->MapPageId(logical_page_id) * PAGE_SIZE;
+  uint32_t slot = free_slots_.back();
+  free_slots_.pop_back();
+  requests_[slot] = {page_data, offset, is_read, std::move(callback)};
+
+  uint32_t tail = *sq_tail_;
+  uint32_t index = tail & sq_mask_;
+  auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+  sqe->fd = disk_manager_->db_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(page_data);
+  sqe->len = PAGE_SIZE;
+  sqe->off = offset;
+  sqe->user_data = slot;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  num_queued_++;
+}
+
+size_t AsyncIO::Submit() {
+  if (num_queued_ == 0) return 0;
+  int ret;
+  do {
+    ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, num_queued_, 0, 0, nullptr, 0));
+  } while (ret < 0 && errno == EINTR);
+  ASSERT(ret >= 0, "io_uring_enter failed to submit.");
+  num_queued_ -= ret;
+  num_in_flight_ += ret;
+  return ret;
+}
+
+size_t AsyncIO::Reap(unsigned min_complete) {
+  if (min_complete > 0) {
+    int ret;
+    do {
+      ret = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd_, 0, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+    } while (ret < 0 && errno == EINTR);
+    ASSERT(ret >= 0, "io_uring_enter failed to wait.");
+  }
+  size_t num_reaped = 0;
+  uint32_t head = *cq_head_;
+  uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    auto *cqe = static_cast<io_uring_cqe *>(cqes_) + (head & cq_mask_);
+    auto slot = static_cast<uint32_t>(cqe->user_data);
+    int result = cqe->res;
+    head++;
+    // hand the entry back before running the callback, which may queue more requests
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    Complete(slot, result);
+    num_reaped++;
+    tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  }
+  return num_reaped;
+}
+
+#else
+
+bool AsyncIO::SetupRing() { return false; }
+
+void AsyncIO::TeardownRing() {}
+
+void AsyncIO::Enqueue(page_id_t logical_page_id, char *page_data, bool is_read, IOCallback callback) {
+  if (is_read) {
+    disk_manager_->ReadPage(logical_page_id, page_data);
+  } else {
+    disk_manager_->WritePage(logical_page_id, page_data);
+  }
+  if (callback) callback(true);
+}
+
+size_t AsyncIO::Submit() { return 0; }
+
+size_t AsyncIO::Reap(unsigned) { return 0; }
+
+#endif
+
+/**
+ * A read which ends early has reached the end of the file, the rest of the page reads as zeros like ReadPage does.
+ */
+void AsyncIO::Complete(uint32_t slot, int result) {
+  Request request = std::move(requests_[slot]);
+  requests_[slot] = Request();
+  free_slots_.push_back(slot);
+  num_in_flight_--;
+  bool ok;
+  if (request.is_read_) {
+    ok = result >= 0;
+    if (ok && result < PAGE_SIZE) memset(request.data_ + result, 0, PAGE_SIZE - result);
+    if (ok && !disk_manager_->MatchesChecksum(request.offset_ / PAGE_SIZE, request.data_)) {
+      // FetchPage reads the page again and reports it
+      LOG(ERROR) << "Page at offset " << request.offset_ << " does not match its checksum";
+      if (request.callback_) request.callback_(false);
+      return;
+    }
+  } else {
+    ok = result == PAGE_SIZE;
+    if (ok) {
+      disk_manager_->ExtendFileSize(request.offset_ + PAGE_SIZE);
+      disk_manager_->StampChecksum(request.offset_ / PAGE_SIZE, request.data_);
+    }
+  }
+  if (!ok) {
+    LOG(ERROR) << "I/O error in asynchronous " << (request.is_read_ ? "read" : "write") << ": " << result;
+  }
+  if (request.callback_) request.callback_(ok);
+}
@@ -1,110 +1,305 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
+#include "common/crc32c.h"
+#include "common/lz4.h"
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+/**
+ * Marks a page without a checksum, the side file is extended with it. It is not 0, so that a stretch of the side file
+ * which was zeroed is reported rather than silently unchecked. A page whose CRC happens to be it is stamped with 0.
+ */
+static constexpr uint32_t CHECKSUM_UNKNOWN = UINT32_MAX;
+
+static uint32_t PageChecksum(const char *page_data) {
+  uint32_t crc = Crc32c(page_data, PAGE_SIZE);
+  return crc == CHECKSUM_UNKNOWN ? 0 : crc;
+}
+
+/**
+ * Entry of a compressed page in db_file.cmap: bit 63 set if the page has a run, bit 62 set if it is stored
+ * uncompressed because it did not shrink, bits 48 to 61 the stored length in bytes, bits 0 to 47 the first sector.
+ */
+static constexpr uint64_t ENTRY_PRESENT = uint64_t{1} << 63;
+static constexpr uint64_t ENTRY_RAW = uint64_t{1} << 62;
+
+static uint64_t MakeEntry(uint64_t first_sector, uint32_t length, bool raw) {
+  return ENTRY_PRESENT | (raw ? ENTRY_RAW : 0) | (static_cast<uint64_t>(length) << 48) | first_sector;
+}
+
+static uint64_t EntrySector(uint64_t entry) { return entry & ((uint64_t{1} << 48) - 1); }
+
+static uint32_t EntryLength(uint64_t entry) { return static_cast<uint32_t>((entry >> 48) & 0x3fff); }
+
+static uint32_t EntrySectors(uint64_t entry) {
+  return (EntryLength(entry) + DiskManager::SECTOR_SIZE - 1) / DiskManager::SECTOR_SIZE;
+}
+
+// .warm holds the page ids BufferPoolManager::DumpResidentPages writes at shutdown
+static const char *SIDE_FILE_SUFFIXES[] = {".crc", ".cmap", ".cdat", ".warm"};
+
+DiskManager::DiskManager(const std::string &db_file, bool preallocate_extents)
+    : file_name_(db_file), preallocate_extents_(preallocate_extents) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::exception();
-    }
+  // create the directory if needed, the file itself is created by open
+  std::filesystem::path p = db_file;
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw std::exception();
   }
+  file_size_ = GetFileSize(file_name_);
 
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  meta_pages_.emplace_back(std::make_unique<MetaPageImage>());
+  meta_dirty_.push_back(false);
+  ReadPhysicalPage(META_PAGE_ID, meta_pages_[0]->data_);
+  uint32_t num_extents = GetMetaPage(0)->GetExtentNums();
+  for (uint32_t meta_index = 1; meta_index * EXTENTS_PER_META_PAGE < num_extents; meta_index++) {
+    meta_pages_.emplace_back(std::make_unique<MetaPageImage>());
+    meta_dirty_.push_back(false);
+    ReadPhysicalPage(MapMetaPageId(meta_index), meta_pages_.back()->data_);
+  }
+  for (uint32_t extent_index = 0; extent_index < num_extents; extent_index++) {
+    bitmaps_.emplace_back(std::make_unique<BitmapPageImage>());
+    ReadPhysicalPage(MapBitmapPageId(extent_index), reinterpret_cast<char *>(bitmaps_.back().get()));
+    bitmap_dirty_.push_back(false);
+    if (ExtentUsedPage(extent_index) < BITMAP_SIZE) free_extents_.insert(extent_index);
+  }
+  if (std::filesystem::exists(file_name_ + ".cmap")) EnableCompression();
+  // once stamped, pages have to stay stamped or their checksums go stale
+  if (std::filesystem::exists(file_name_ + ".crc")) EnableChecksums();
+}
+
+/**
+ * With checksums on, the pages are synced before the stamps, so that a crash of the system after the checkpoint finds
+ * the stamps of the pages written before it on disk, along with the pages.
+ */
+void DiskManager::Checkpoint() {
+  {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    for (size_t extent_index = 0; extent_index < bitmaps_.size(); extent_index++) {
+      if (!bitmap_dirty_[extent_index]) continue;
+      WritePhysicalPage(MapBitmapPageId(extent_index), reinterpret_cast<const char *>(bitmaps_[extent_index].get()));
+      bitmap_dirty_[extent_index] = false;
+    }
+    for (size_t meta_index = 0; meta_index < meta_pages_.size(); meta_index++) {
+      if (!meta_dirty_[meta_index]) continue;
+      WritePhysicalPage(MapMetaPageId(meta_index), meta_pages_[meta_index]->data_);
+      meta_dirty_[meta_index] = false;
+    }
+  }
+  // a page stamped during the sync sets the flag again and is synced by the next checkpoint
+  if (checksums_ != nullptr && checksums_dirty_.exchange(false)) {
+    bool synced = fdatasync(db_fd_) == 0 && (compressed_map_ == nullptr || fdatasync(cdat_fd_) == 0);
+    if (!synced || msync(checksums_, num_checksums_.load() * sizeof(uint32_t), MS_SYNC) != 0) {
+      LOG(ERROR) << "I/O error while syncing the checksums of " << file_name_;
+    }
+  }
 }
 
 void DiskManager::Close() {
+  StopScrubber();
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    Checkpoint();
+    if (mapping_ != nullptr) munmap(mapping_, MAPPING_RESERVE);
+    if (checksums_ != nullptr) {
+      munmap(checksums_, CHECKSUM_RESERVE);
+      close(crc_fd_);
+    }
+    if (compressed_map_ != nullptr) {
+      munmap(compressed_map_, COMPRESSED_MAP_RESERVE);
+      close(cmap_fd_);
+      close(cdat_fd_);
+    }
+    close(db_fd_);
     closed = true;
   }
 }
 
+/**
+ * Callers have no way to handle a bad page, so a page which does not match its checksum is still handed back.
+ */
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  if (!ReadLogicalPage(logical_page_id, page_data)) ReportCorruptPage(logical_page_id);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (compressed_map_ != nullptr) {
+    WriteCompressedPage(logical_page_id, page_data);
+    return;
+  }
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
+bool DiskManager::ReadLogicalPage(page_id_t logical_page_id, char *page_data) {
+  int64_t physical_page_id = MapPageId(logical_page_id);
+  uint64_t entry = GetCompressedEntry(logical_page_id);
+  if (entry == 0) return ReadPhysicalPage(physical_page_id, page_data);
+  char buffer[PAGE_SIZE];
+  uint32_t length = EntryLength(entry);
+  char *target = (entry & ENTRY_RAW) != 0 ? page_data : buffer;
+  int64_t offset = static_cast<int64_t>(EntrySector(entry)) * SECTOR_SIZE;
+  uint32_t read_count = 0;
+  while (read_count < length) {
+    ssize_t rc = pread(cdat_fd_, target + read_count, length - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc <= 0) break;
+    read_count += rc;
+  }
+  if (read_count < length) {
+    LOG(ERROR) << "I/O error while reading compressed page " << logical_page_id;
+    memset(page_data, 0, PAGE_SIZE);
+    return false;
+  }
+  if ((entry & ENTRY_RAW) == 0 && Lz4DecompressBlock(buffer, length, page_data, PAGE_SIZE) != PAGE_SIZE) {
+    memset(page_data, 0, PAGE_SIZE);
+    return false;
+  }
+  return MatchesChecksum(physical_page_id, page_data);
+}
+
+/**
+ * A page which does not shrink by at least a sector is stored as it is. The checksum covers the uncompressed page.
+ */
+void DiskManager::WriteCompressedPage(page_id_t logical_page_id, const char *page_data) {
+  char buffer[PAGE_SIZE];
+  int size = Lz4CompressBlock(page_data, PAGE_SIZE, buffer, PAGE_SIZE - SECTOR_SIZE);
+  bool raw = size == 0;
+  const char *source = raw ? page_data : buffer;
+  uint32_t length = raw ? PAGE_SIZE : size;
+  uint32_t num_sectors = (length + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  if (!raw) memset(buffer + length, 0, num_sectors * SECTOR_SIZE - length);
+  uint64_t first_sector;
+  {
+    std::scoped_lock<std::mutex> lock(compress_latch_);
+    first_sector = AllocateSectors(num_sectors);
+  }
+  int64_t offset = static_cast<int64_t>(first_sector) * SECTOR_SIZE;
+  size_t write_count = 0;
+  while (write_count < num_sectors * SECTOR_SIZE) {
+    ssize_t rc = pwrite(cdat_fd_, source + write_count, num_sectors * SECTOR_SIZE - write_count, offset + write_count);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while writing compressed page " << logical_page_id;
+      std::scoped_lock<std::mutex> lock(compress_latch_);
+      free_runs_[num_sectors].push_back(first_sector);
+      return;
+    }
+    write_count += rc;
+  }
+  SetCompressedEntry(logical_page_id, MakeEntry(first_sector, length, raw));
+  StampChecksum(MapPageId(logical_page_id), page_data);
+}
+
+uint64_t DiskManager::GetCompressedEntry(page_id_t logical_page_id) {
+  if (compressed_map_ == nullptr || logical_page_id >= num_compressed_entries_.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  return __atomic_load_n(&compressed_map_[logical_page_id], __ATOMIC_ACQUIRE);
+}
+
+void DiskManager::SetCompressedEntry(page_id_t logical_page_id, uint64_t entry) {
+  std::scoped_lock<std::mutex> lock(compress_latch_);
+  int64_t num_entries = num_compressed_entries_.load();
+  if (logical_page_id >= num_entries) {
+    if (entry == 0) return;
+    int64_t bytes = (static_cast<int64_t>(logical_page_id) + 1) * static_cast<int64_t>(sizeof(uint64_t));
+    bytes = std::min((bytes + CHECKSUM_CHUNK - 1) / CHECKSUM_CHUNK * CHECKSUM_CHUNK, COMPRESSED_MAP_RESERVE);
+    if (!MapSideFile(cmap_fd_, reinterpret_cast<char *>(compressed_map_),
+                     num_entries * static_cast<int64_t>(sizeof(uint64_t)), bytes)) {
+      free_runs_[EntrySectors(entry)].push_back(EntrySector(entry));
+      return;
+    }
+    num_compressed_entries_.store(bytes / static_cast<int64_t>(sizeof(uint64_t)), std::memory_order_release);
+  }
+  uint64_t old_entry = __atomic_exchange_n(&compressed_map_[logical_page_id], entry, __ATOMIC_ACQ_REL);
+  if (entry != 0) num_used_sectors_ += EntrySectors(entry);
+  if (old_entry != 0) {
+    free_runs_[EntrySectors(old_entry)].push_back(EntrySector(old_entry));
+    num_used_sectors_ -= EntrySectors(old_entry);
+  }
+}
+
+/**
+ * A run is taken from the free runs of its length, split off a longer free run, or appended to the end of the file.
+ * Runs are at most a page long, so free space is never coalesced.
+ */
+uint64_t DiskManager::AllocateSectors(uint32_t num_sectors) {
+  for (uint32_t length = num_sectors; length <= MAX_RUN_SECTORS; length++) {
+    if (free_runs_[length].empty()) continue;
+    uint64_t first_sector = free_runs_[length].back();
+    free_runs_[length].pop_back();
+    if (length > num_sectors) free_runs_[length - num_sectors].push_back(first_sector + num_sectors);
+    return first_sector;
+  }
+  uint64_t first_sector = num_sectors_;
+  num_sectors_ += num_sectors;
+  return first_sector;
+}
+
+uint64_t DiskManager::GetCompressedBytes() {
+  std::scoped_lock<std::mutex> lock(compress_latch_);
+  return num_used_sectors_ * SECTOR_SIZE;
+}
+
 /**
  * Zat Implement
+ * The lowest extent with a free page comes from free_extents_ and its bitmap finds the page through next_free_page_,
+ * so no bitmap is read or scanned. The changes stay in memory until the next Checkpoint. The first extent of every
+ * group of EXTENTS_PER_META_PAGE extents brings a new meta page with it.
  */
 page_id_t DiskManager::AllocatePage() {
   std::scoped_lock lock(db_io_latch_);
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
-  auto *pm = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  auto *pm = GetMetaPage(0);
   uint32_t offset;
 
   //==============满了==================
-  if(pm->GetAllocatedPages() >= MAX_VALID_PAGE_ID) return INVALID_PAGE_ID;
-  
-  //=============正常插入=====================
-  for (page_id_t extent_index = 0; extent_index < pm->GetExtentNums(); extent_index++) {
-    // 每个bitmap取出来看一眼再丢回去，这里for的是逻辑页号
-    // meta_page_id就是0
-    page_id_t phy_bitmap_addr = META_PAGE_ID + 1 + extent_index * (1 + BITMAP_SIZE);
-    char bitmap_buffer[PAGE_SIZE];
-    ReadPhysicalPage(phy_bitmap_addr, bitmap_buffer);
-    auto *pb = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_buffer);
-    if(pb->AllocatePage(offset)){
-      // allocate更新的部分写回
-      WritePhysicalPage(phy_bitmap_addr, bitmap_buffer);
-      // disk manager的meta data更新
-      pm->num_allocated_pages_++;
-      pm->extent_used_page_[extent_index]++;
-      WritePhysicalPage(META_PAGE_ID, meta_data_);
-      return extent_index * BITMAP_SIZE + offset;
-    }
-  }
-  
+  if (free_extents_.empty() && pm->GetExtentNums() >= MAX_EXTENTS) return INVALID_PAGE_ID;
+
   //==============新开一页===============
-  uint32_t new_index = pm->GetExtentNums();
-  // meta data 更新 （写回在最后，让所有write集中一点？)
-  pm->extent_used_page_[new_index] = 0;
-  pm->num_extents_++;
-  pm->num_allocated_pages_++;
-  pm->extent_used_page_[new_index]++;
-  
-  // 新开BITMAP_SIZE+1页（位图+数据）（先设为全0）
-  page_id_t new_phy_bitmap_addr = META_PAGE_ID + 1 + new_index * (1 + BITMAP_SIZE);
-  char zero[PAGE_SIZE] = {0};
-  WritePhysicalPage(new_phy_bitmap_addr, zero);
-  for (uint32_t i = 1; i <= BITMAP_SIZE; i++) {
-    WritePhysicalPage(new_phy_bitmap_addr + i, zero);
+  if (free_extents_.empty()) {
+    uint32_t new_index = pm->GetExtentNums();
+    if (new_index / EXTENTS_PER_META_PAGE == meta_pages_.size()) {
+      meta_pages_.emplace_back(std::make_unique<MetaPageImage>());
+      meta_dirty_.push_back(true);
+    }
+    ExtentUsedPage(new_index) = 0;
+    pm->num_extents_++;
+    // 新开BITMAP_SIZE页数据, 不用写0, 没写过的页读出来就是0; 位图页只在内存里
+    ReserveExtent(new_index);
+    bitmaps_.emplace_back(std::make_unique<BitmapPageImage>());
+    bitmap_dirty_.push_back(true);
+    free_extents_.insert(new_index);
   }
 
-  // 空的，offset=0即可
-  auto *new_pb = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(zero);
-  offset = 0;
-  new_pb->AllocatePage(offset);
-  WritePhysicalPage(new_phy_bitmap_addr, zero);
-
-  // 更新 meta data
-  
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
-  return new_index * BITMAP_SIZE + offset;
+  //=============正常插入=====================
+  uint32_t extent_index = *free_extents_.begin();
+  bool ok = bitmaps_[extent_index]->AllocatePage(offset);
+  ASSERT(ok, "Extent with free space has a full bitmap.");
+  bitmap_dirty_[extent_index] = true;
+  pm->num_allocated_pages_++;
+  ExtentUsedPage(extent_index)++;
+  meta_dirty_[0] = true;
+  meta_dirty_[extent_index / EXTENTS_PER_META_PAGE] = true;
+  if (ExtentUsedPage(extent_index) == BITMAP_SIZE) free_extents_.erase(extent_index);
+  return extent_index * BITMAP_SIZE + offset;
 }
 
 /**
@@ -112,25 +307,22 @@ page_id_t DiskManager::AllocatePage() {
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
   std::scoped_lock lock(db_io_latch_);
-  auto *pm = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  auto *pm = GetMetaPage(0);
 
   page_id_t extent_index  = logical_page_id / BITMAP_SIZE;
   page_id_t extent_offset = logical_page_id % BITMAP_SIZE;
 
-  if (extent_index >= pm->GetExtentNums()) return;
-
-  // 访问相应bitmap
-  page_id_t phy_bitmap_addr = META_PAGE_ID + 1 + extent_index * (1 + BITMAP_SIZE);
-  char bitmap_buffer[PAGE_SIZE];
-  ReadPhysicalPage(phy_bitmap_addr, bitmap_buffer);
-  auto *pb = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_buffer);
+  if (extent_index >= static_cast<page_id_t>(pm->GetExtentNums())) return;
 
   // 尝试deallocate
-  if (pb->DeAllocatePage(extent_offset)) {
+  if (bitmaps_[extent_index]->DeAllocatePage(extent_offset)) {
+    bitmap_dirty_[extent_index] = true;
     pm->num_allocated_pages_--;
-    pm->extent_used_page_[extent_index]--;
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
-    WritePhysicalPage(phy_bitmap_addr, bitmap_buffer);
+    ExtentUsedPage(extent_index)--;
+    meta_dirty_[0] = true;
+    meta_dirty_[extent_index / EXTENTS_PER_META_PAGE] = true;
+    free_extents_.insert(extent_index);
+    if (GetCompressedEntry(logical_page_id) != 0) SetCompressedEntry(logical_page_id, 0);
   }
 }
 
@@ -139,7 +331,7 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
   std::scoped_lock lock(db_io_latch_);
-  auto *pm = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  auto *pm = GetMetaPage(0);
 
   if (pm->GetExtentNums() == 0) return true;
 
@@ -147,65 +339,389 @@ bool DiskManager::IsPageFree(page_id_t logical_page_id) {
   page_id_t extent_offset = logical_page_id % BITMAP_SIZE;
 
   // 特判：GetExtentNums为0的时候要保证前两页为空，从而正确初始化
-  if (extent_index >= pm->GetExtentNums()) return false; // 没被建的页视为不空
+  if (extent_index >= static_cast<page_id_t>(pm->GetExtentNums())) return false; // 没被建的页视为不空
 
-  // 访问bitmap
-  page_id_t phy_bitmap_addr = META_PAGE_ID + 1 + extent_index * (1 + BITMAP_SIZE);
-  char bitmap_buffer[PAGE_SIZE];
-  ReadPhysicalPage(phy_bitmap_addr, bitmap_buffer);
-  auto *pb = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_buffer);
-  return pb->IsPageFree(extent_offset);
+  return bitmaps_[extent_index]->IsPageFree(extent_offset);
 }
 
 /**
  * Zat Implement
  */
-page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
+int64_t DiskManager::MapPageId(page_id_t logical_page_id) {
   page_id_t Extent_index  = logical_page_id / BITMAP_SIZE;
   page_id_t Extent_offset = logical_page_id % BITMAP_SIZE;
-  page_id_t phy_bitmap = META_PAGE_ID + 1 + Extent_index * (1 + BITMAP_SIZE);
+  int64_t phy_bitmap = MapBitmapPageId(Extent_index);
   return phy_bitmap + 1 + Extent_offset; //在位图页的基础上 移一页（bitmap） 再加 offset
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
 }
 
-void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+bool DiskManager::ReadPhysicalPage(int64_t physical_page_id, char *page_data) {
+  int64_t offset = physical_page_id * PAGE_SIZE;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset >= file_size_) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    return true;
+  }
+  // O_DIRECT transfers into an aligned buffer only
+  alignas(DIRECT_IO_ALIGNMENT) static thread_local char bounce[PAGE_SIZE];
+  char *target = IsDirectIOEnabled() && !IsDirectIOAligned(page_data) ? bounce : page_data;
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, target + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while reading";
+      break;
+    }
+    // file ends before reading PAGE_SIZE
+    if (rc == 0) break;
+    read_count += rc;
+  }
+  if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
+    LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    memset(target + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (target != page_data) memcpy(page_data, target, PAGE_SIZE);
+  return MatchesChecksum(physical_page_id, page_data);
+}
+
+void DiskManager::WritePhysicalPage(int64_t physical_page_id, const char *page_data) {
+  int64_t offset = physical_page_id * PAGE_SIZE;
+  alignas(DIRECT_IO_ALIGNMENT) static thread_local char bounce[PAGE_SIZE];
+  const char *source = page_data;
+  if (IsDirectIOEnabled() && !IsDirectIOAligned(page_data)) {
+    memcpy(bounce, page_data, PAGE_SIZE);
+    source = bounce;
+  }
+  size_t write_count = 0;
+  while (write_count < PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, source + write_count, PAGE_SIZE - write_count, offset + write_count);
+    if (rc < 0 && errno == EINTR) continue;
+    // check for I/O error
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while writing";
+      return;
     }
+    write_count += rc;
   }
+  // pwrite hands the page to the kernel directly, there is no user space buffer left to flush
+  ExtendFileSize(offset + PAGE_SIZE);
+  StampChecksum(physical_page_id, page_data);
 }
 
-void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+/**
+ * fallocate gives the extent real zeroed blocks, ftruncate only moves the end of the file and leaves a hole which the
+ * file system fills on the first write of each page. Either way no page is written here. A file system which does
+ * not support fallocate gets the hole.
+ */
+void DiskManager::ReserveExtent(uint32_t extent_index) {
+  int64_t end = (MapBitmapPageId(extent_index) + 1 + BITMAP_SIZE) * PAGE_SIZE;
+  int64_t size = file_size_.load();
+  if (end <= size) return;
+  int rc = -1;
+#ifdef __linux__
+  if (preallocate_extents_) rc = fallocate(db_fd_, 0, size, end - size);
+#endif
+  if (rc != 0 && ftruncate(db_fd_, end) != 0) {
+    LOG(ERROR) << "I/O error while reserving extent " << extent_index;
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  ExtendFileSize(end);
+  GrowMapping(end);
+}
+
+/**
+ * O_DIRECT is switched on for the open descriptor, which the io_uring requests of AsyncIO share. The pages written
+ * through the page cache so far are synced first, direct reads would otherwise have the kernel write them back one at a
+ * time.
+ */
+bool DiskManager::EnableDirectIO() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (IsDirectIOEnabled()) return true;
+#ifdef O_DIRECT
+  if (mapping_ != nullptr) {
+    LOG(WARNING) << "Cannot use O_DIRECT on mapped file " << file_name_;
+    return false;
+  }
+  int flags = fcntl(db_fd_, F_GETFL);
+  if (flags < 0 || fdatasync(db_fd_) != 0 || fcntl(db_fd_, F_SETFL, flags | O_DIRECT) != 0) {
+    LOG(WARNING) << "Failed to enable O_DIRECT for " << file_name_;
+    return false;
+  }
+  direct_io_ = true;
+  return true;
+#else
+  LOG(WARNING) << "O_DIRECT is not supported on this platform";
+  return false;
+#endif
+}
+
+/**
+ * The whole address range is reserved with an inaccessible anonymous mapping, and the file is mapped over its start
+ * piece by piece. Pages handed out by GetMappedPage therefore stay valid while the mapping grows.
+ */
+bool DiskManager::EnableMappedReads() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (mapping_ != nullptr) return true;
+  if (IsDirectIOEnabled()) {
+    LOG(WARNING) << "Mapped reads would bring back the page cache O_DIRECT avoids for " << file_name_;
+    return false;
+  }
+  void *reserved = mmap(nullptr, MAPPING_RESERVE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (reserved == MAP_FAILED) {
+    LOG(WARNING) << "Failed to reserve address space for mapping " << file_name_;
+    return false;
+  }
+  mapping_ = static_cast<char *>(reserved);
+  GrowMapping(file_size_);
+  return true;
+}
+
+void DiskManager::GrowMapping(int64_t end) {
+  if (mapping_ == nullptr) return;
+  end = std::min(end - end % PAGE_SIZE, MAPPING_RESERVE);
+  int64_t mapped = mapped_size_.load();
+  if (end <= mapped) return;
+  void *addr = mmap(mapping_ + mapped, end - mapped, PROT_READ, MAP_SHARED | MAP_FIXED, db_fd_, mapped);
+  if (addr == MAP_FAILED) {
+    LOG(WARNING) << "Failed to grow the mapping of " << file_name_;
+    return;
+  }
+  mapped_size_.store(end, std::memory_order_release);
+}
+
+char *DiskManager::GetMappedPage(page_id_t logical_page_id) {
+  if (compressed_map_ != nullptr) return nullptr;
+  int64_t mapped = mapped_size_.load(std::memory_order_acquire);
+  int64_t offset = MapPageId(logical_page_id) * PAGE_SIZE;
+  if (offset + PAGE_SIZE > mapped) return nullptr;
+  return mapping_ + offset;
+}
+
+/**
+ * The meta and bitmap pages were read before the checksums were available, they are checked here instead.
+ */
+bool DiskManager::EnableChecksums() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (checksums_ != nullptr) return true;
+  std::string crc_file_name = file_name_ + ".crc";
+  crc_fd_ = open(crc_file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (crc_fd_ < 0) {
+    LOG(WARNING) << "Failed to open " << crc_file_name;
+    return false;
+  }
+  void *reserved = mmap(nullptr, CHECKSUM_RESERVE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (reserved == MAP_FAILED) {
+    LOG(WARNING) << "Failed to reserve address space for mapping " << crc_file_name;
+    close(crc_fd_);
+    crc_fd_ = -1;
+    return false;
+  }
+  checksums_ = static_cast<uint32_t *>(reserved);
+  GrowChecksums(std::max(file_size_.load() / PAGE_SIZE, GetFileSize(crc_file_name) / 4));
+  alignas(DIRECT_IO_ALIGNMENT) char page_data[PAGE_SIZE];
+  for (size_t meta_index = 0; meta_index < meta_pages_.size(); meta_index++) {
+    if (!meta_dirty_[meta_index] && !ReadPhysicalPage(MapMetaPageId(meta_index), page_data)) {
+      LOG(ERROR) << "Meta page " << meta_index << " of " << file_name_ << " does not match its checksum";
+    }
+  }
+  for (size_t extent_index = 0; extent_index < bitmaps_.size(); extent_index++) {
+    if (!bitmap_dirty_[extent_index] && !ReadPhysicalPage(MapBitmapPageId(extent_index), page_data)) {
+      LOG(ERROR) << "Bitmap page of extent " << extent_index << " of " << file_name_ << " does not match its checksum";
+    }
+  }
+  return true;
+}
+
+/**
+ * Chunks are multiples of any page size of the host, so every chunk can be mapped at its offset in the side file.
+ */
+void DiskManager::GrowChecksums(int64_t num_pages) {
+  std::scoped_lock<std::mutex> lock(checksum_latch_);
+  int64_t mapped_bytes = num_checksums_.load() * static_cast<int64_t>(sizeof(uint32_t));
+  int64_t bytes = num_pages * static_cast<int64_t>(sizeof(uint32_t));
+  bytes = std::min((bytes + CHECKSUM_CHUNK - 1) / CHECKSUM_CHUNK * CHECKSUM_CHUNK, CHECKSUM_RESERVE);
+  if (bytes <= mapped_bytes) return;
+  struct stat stat_buf;
+  int64_t file_bytes = fstat(crc_fd_, &stat_buf) == 0 ? stat_buf.st_size : 0;
+  if (!MapSideFile(crc_fd_, reinterpret_cast<char *>(checksums_), mapped_bytes, bytes)) return;
+  // the side file grew with zeros, the new entries are not stamped yet
+  int64_t fill_from = std::max(mapped_bytes, file_bytes);
+  if (fill_from < bytes) memset(reinterpret_cast<char *>(checksums_) + fill_from, 0xff, bytes - fill_from);
+  num_checksums_.store(bytes / static_cast<int64_t>(sizeof(uint32_t)), std::memory_order_release);
+}
+
+bool DiskManager::MapSideFile(int fd, char *base, int64_t from, int64_t to) {
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) != 0 || (stat_buf.st_size < to && ftruncate(fd, to) != 0)) {
+    LOG(ERROR) << "I/O error while growing a side file of " << file_name_;
+    return false;
+  }
+  void *addr = mmap(base + from, to - from, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, from);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Failed to grow the mapping of a side file of " << file_name_;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The free runs are not stored, they are the gaps between the runs the map points to.
+ */
+bool DiskManager::EnableCompression() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  std::scoped_lock<std::mutex> compress_lock(compress_latch_);
+  if (compressed_map_ != nullptr) return true;
+  cmap_fd_ = open((file_name_ + ".cmap").c_str(), O_RDWR | O_CREAT, 0644);
+  cdat_fd_ = open((file_name_ + ".cdat").c_str(), O_RDWR | O_CREAT, 0644);
+  void *reserved = MAP_FAILED;
+  if (cmap_fd_ >= 0 && cdat_fd_ >= 0) {
+    reserved = mmap(nullptr, COMPRESSED_MAP_RESERVE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  }
+  int64_t map_bytes = GetFileSize(file_name_ + ".cmap");
+  map_bytes -= map_bytes % CHECKSUM_CHUNK;
+  if (reserved == MAP_FAILED || (map_bytes > 0 && !MapSideFile(cmap_fd_, static_cast<char *>(reserved), 0, map_bytes))) {
+    LOG(WARNING) << "Failed to set up the compressed pages of " << file_name_;
+    if (reserved != MAP_FAILED) munmap(reserved, COMPRESSED_MAP_RESERVE);
+    if (cmap_fd_ >= 0) close(cmap_fd_);
+    if (cdat_fd_ >= 0) close(cdat_fd_);
+    cmap_fd_ = cdat_fd_ = -1;
+    return false;
+  }
+  compressed_map_ = static_cast<uint64_t *>(reserved);
+  int64_t num_entries = map_bytes / static_cast<int64_t>(sizeof(uint64_t));
+  std::vector<std::pair<uint64_t, uint32_t>> runs;
+  for (int64_t i = 0; i < num_entries; i++) {
+    if (compressed_map_[i] != 0) runs.emplace_back(EntrySector(compressed_map_[i]), EntrySectors(compressed_map_[i]));
+  }
+  std::sort(runs.begin(), runs.end());
+  num_sectors_ = GetFileSize(file_name_ + ".cdat") / SECTOR_SIZE;
+  uint64_t next_sector = 0;
+  auto add_free_space = [this](uint64_t first_sector, uint64_t end_sector) {
+    while (first_sector < end_sector) {
+      auto length = static_cast<uint32_t>(std::min<uint64_t>(MAX_RUN_SECTORS, end_sector - first_sector));
+      free_runs_[length].push_back(first_sector);
+      first_sector += length;
+    }
+  };
+  for (auto &[first_sector, num_sectors] : runs) {
+    add_free_space(next_sector, first_sector);
+    next_sector = first_sector + num_sectors;
+    num_used_sectors_ += num_sectors;
+  }
+  num_sectors_ = std::max(num_sectors_, next_sector);
+  add_free_space(next_sector, num_sectors_);
+  num_compressed_entries_.store(num_entries, std::memory_order_release);
+  return true;
+}
+
+void DiskManager::RemoveFiles(const std::string &db_file) {
+  remove(db_file.c_str());
+  for (const char *suffix : SIDE_FILE_SUFFIXES) {
+    remove((db_file + suffix).c_str());
+  }
+}
+
+bool DiskManager::IsSideFile(const std::string &file_name) {
+  for (const char *suffix : SIDE_FILE_SUFFIXES) {
+    size_t length = strlen(suffix);
+    if (file_name.size() > length && file_name.compare(file_name.size() - length, length, suffix) == 0) return true;
+  }
+  return false;
+}
+
+void DiskManager::StampChecksum(int64_t physical_page_id, const char *page_data) {
+  if (checksums_ == nullptr) return;
+  if (physical_page_id >= num_checksums_.load(std::memory_order_acquire)) GrowChecksums(physical_page_id + 1);
+  if (physical_page_id >= num_checksums_.load(std::memory_order_acquire)) return;
+  __atomic_store_n(&checksums_[physical_page_id], PageChecksum(page_data), __ATOMIC_RELAXED);
+  if (!checksums_dirty_.load(std::memory_order_relaxed)) checksums_dirty_ = true;
+}
+
+bool DiskManager::MatchesChecksum(int64_t physical_page_id, const char *page_data) {
+  if (checksums_ == nullptr || physical_page_id >= num_checksums_.load(std::memory_order_acquire)) return true;
+  uint32_t checksum = __atomic_load_n(&checksums_[physical_page_id], __ATOMIC_RELAXED);
+  return checksum == CHECKSUM_UNKNOWN || checksum == PageChecksum(page_data);
+}
+
+void DiskManager::ReportCorruptPage(page_id_t logical_page_id) {
+  LOG(ERROR) << "Page " << logical_page_id << " of " << file_name_ << " does not match its checksum";
+  std::scoped_lock<std::mutex> lock(checksum_latch_);
+  corrupt_pages_.insert(logical_page_id);
+}
+
+std::vector<page_id_t> DiskManager::GetCorruptPages() {
+  std::scoped_lock<std::mutex> lock(checksum_latch_);
+  return std::vector<page_id_t>(corrupt_pages_.begin(), corrupt_pages_.end());
+}
+
+void DiskManager::StartScrubber(std::chrono::milliseconds pause, size_t pages_per_step) {
+  ASSERT(pages_per_step > 0, "Scrubber must visit at least one page per step.");
+  if (checksums_ == nullptr || scrubber_.joinable()) return;
+  stop_scrubber_ = false;
+  scrubber_ = std::thread(&DiskManager::Scrub, this, pause, pages_per_step);
+}
+
+void DiskManager::StopScrubber() {
+  if (!scrubber_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(scrubber_latch_);
+    stop_scrubber_ = true;
+  }
+  scrubber_cv_.notify_all();
+  scrubber_.join();
+}
+
+/**
+ * The scrubber reads the file directly, so a page may be written between its read and the check. A page which does
+ * not match is therefore read a second time before it is reported.
+ */
+void DiskManager::Scrub(std::chrono::milliseconds pause, size_t pages_per_step) {
+#ifdef __linux__
+  // on Linux the nice value is per thread, the scrubber only gets the CPU nobody else wants
+  setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+  alignas(DIRECT_IO_ALIGNMENT) char page_data[PAGE_SIZE];
+  page_id_t next_page_id = 0;
+  std::unique_lock<std::mutex> lock(scrubber_latch_);
+  while (!scrubber_cv_.wait_for(lock, pause, [this] { return stop_scrubber_; })) {
+    lock.unlock();
+    for (size_t i = 0; i < pages_per_step; i++) {
+      bool allocated;
+      {
+        std::scoped_lock<std::recursive_mutex> io_lock(db_io_latch_);
+        if (bitmaps_.empty()) break;
+        // past the last extent the next pass starts
+        if (static_cast<size_t>(next_page_id) >= bitmaps_.size() * BITMAP_SIZE) next_page_id = 0;
+        allocated = !bitmaps_[next_page_id / BITMAP_SIZE]->IsPageFree(next_page_id % BITMAP_SIZE);
+      }
+      page_id_t page_id = next_page_id++;
+      if (!allocated) continue;
+      if (!ReadLogicalPage(page_id, page_data) && !ReadLogicalPage(page_id, page_data)) {
+        ReportCorruptPage(page_id);
+      }
+      num_scrubbed_pages_++;
+    }
+    lock.lock();
+  }
+}
+
+void DiskManager::ExtendFileSize(int64_t end) {
+  int64_t size = file_size_.load();
+  while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+std::unique_ptr<AsyncIO> DiskManager::CreateAsyncIO(size_t queue_depth, bool use_io_uring) {
+  return std::make_unique<AsyncIO>(this, queue_depth, use_io_uring);
+}
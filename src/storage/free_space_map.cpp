@@ -0,0 +1,122 @@
+#include "storage/free_space_map.h"
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager), tree_(2, 0) {
+  PageGuard guard = buffer_pool_manager_->NewPageGuarded(root_page_id_);
+  ASSERT(guard.IsValid(), "FreeSpaceMap ctor: failed to allocate first page");
+  reinterpret_cast<FreeSpaceMapPage *>(guard.GetPage())->Init(root_page_id_);
+  guard.MarkDirty();
+  map_pages_.push_back(root_page_id_);
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t root_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), root_page_id_(root_page_id), tree_(2, 0) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (page_id_t page_id = root_page_id_; page_id != INVALID_PAGE_ID;) {
+    ReadPageGuard page_guard = buffer_pool_manager_->FetchPageRead(page_id);
+    ASSERT(page_guard.IsValid(), "FreeSpaceMap ctor: failed to fetch map page");
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page_guard.GetPage());
+    map_pages_.push_back(page_id);
+    for (uint32_t i = 0; i < map_page->GetEntryCount(); i++) {
+      entries_[map_page->GetHeapPageId(i)] = heap_pages_.size();
+      heap_pages_.push_back(map_page->GetHeapPageId(i));
+      SetTreeCategory(heap_pages_.size() - 1, map_page->GetCategory(i));
+    }
+    page_id = map_page->GetNextPageId();
+  }
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+  std::lock_guard<std::mutex> guard(latch_);
+  uint32_t required = RequiredCategory(size);
+  if (heap_pages_.empty() || tree_[1] < required) {
+    return INVALID_PAGE_ID;
+  }
+  // the page appended last takes the inserts of a bulk load
+  if (tree_[capacity_ + heap_pages_.size() - 1] >= required) {
+    return heap_pages_.back();
+  }
+  size_t node = 1;
+  while (node < capacity_) {
+    node = tree_[2 * node] >= required ? 2 * node : 2 * node + 1;
+  }
+  return heap_pages_[node - capacity_];
+}
+
+void FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_space) {
+  std::lock_guard<std::mutex> guard(latch_);
+  uint8_t category = ToCategory(free_space);
+  size_t index = heap_pages_.size();
+  if (index > 0 && index % FreeSpaceMapPage::MAX_ENTRIES == 0) {
+    // the last map page is full, chain a new one
+    page_id_t new_page_id;
+    PageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+    ASSERT(new_guard.IsValid(), "FreeSpaceMap: failed to allocate map page");
+    reinterpret_cast<FreeSpaceMapPage *>(new_guard.GetPage())->Init(new_page_id);
+    new_guard.MarkDirty();
+    WritePageGuard last_guard = buffer_pool_manager_->FetchPageWrite(map_pages_.back());
+    reinterpret_cast<FreeSpaceMapPage *>(last_guard.GetPage())->SetNextPageId(new_page_id);
+    map_pages_.push_back(new_page_id);
+  }
+  {
+    WritePageGuard map_guard = buffer_pool_manager_->FetchPageWrite(map_pages_.back());
+    reinterpret_cast<FreeSpaceMapPage *>(map_guard.GetPage())->AppendEntry(page_id, category);
+  }
+  entries_[page_id] = index;
+  heap_pages_.push_back(page_id);
+  SetTreeCategory(index, category);
+}
+
+void FreeSpaceMap::UpdatePage(page_id_t page_id, uint32_t free_space) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) return;
+  size_t index = it->second;
+  uint8_t category = ToCategory(free_space);
+  if (tree_[capacity_ + index] == category) return;
+  SetTreeCategory(index, category);
+  WritePageGuard map_guard = buffer_pool_manager_->FetchPageWrite(map_pages_[index / FreeSpaceMapPage::MAX_ENTRIES]);
+  reinterpret_cast<FreeSpaceMapPage *>(map_guard.GetPage())
+      ->SetCategory(index % FreeSpaceMapPage::MAX_ENTRIES, category);
+}
+
+void FreeSpaceMap::Destroy() {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (page_id_t page_id : map_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  map_pages_.clear();
+  heap_pages_.clear();
+  entries_.clear();
+  root_page_id_ = INVALID_PAGE_ID;
+}
+
+page_id_t FreeSpaceMap::GetLastPageId() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return heap_pages_.empty() ? INVALID_PAGE_ID : heap_pages_.back();
+}
+
+size_t FreeSpaceMap::GetPageCount() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return heap_pages_.size();
+}
+
+void FreeSpaceMap::SetTreeCategory(size_t index, uint8_t category) {
+  if (index >= capacity_) {
+    // double the leaves and rebuild the inner nodes
+    size_t new_capacity = capacity_;
+    while (new_capacity <= index) new_capacity <<= 1;
+    std::vector<uint8_t> new_tree(2 * new_capacity, 0);
+    std::copy(tree_.begin() + capacity_, tree_.end(), new_tree.begin() + new_capacity);
+    for (size_t node = new_capacity - 1; node > 0; node--) {
+      new_tree[node] = std::max(new_tree[2 * node], new_tree[2 * node + 1]);
+    }
+    capacity_ = new_capacity;
+    tree_.swap(new_tree);
+  }
+  size_t node = capacity_ + index;
+  tree_[node] = category;
+  for (node >>= 1; node > 0; node >>= 1) {
+    tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+  }
+}
@@ -1,74 +1,133 @@
 #include "storage/table_heap.h"
 
+#include <utility>
+
 /**
  * Zat Implement
  */
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
+  uint32_t serialized_size = row.GetSerializedSize(schema_);
+  if (serialized_size >= TablePage::SIZE_MAX_ROW) return false;
+  uint32_t insert_size = TablePage::GetInsertSize(serialized_size);
+
+  // 先去空闲空间表里找放得下的页，类别只是提示，放不下就按页上真实的空间更新后再找
+  for (page_id_t p = free_space_map_->FindPage(insert_size); p != INVALID_PAGE_ID;
+       p = free_space_map_->FindPage(insert_size)) {
+    // the guard unpins the page, dirty only if the tuple went in
+    PageGuard guard = buffer_pool_manager_->FetchPageGuarded(p);
+    ASSERT(guard.IsValid(), "A fetched page but nullptr!");
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
 
-  if(row.GetSerializedSize(schema_) >= TablePage::SIZE_MAX_ROW) return false; 
-  page_id_t p = first_page_id_;
-  page_id_t last_p = first_page_id_;//记录链表末尾的page id方便新开
-  
-  bool success;
-  while(p != INVALID_PAGE_ID) {
-    //这里 Pin ! 记得 Unpin!
-    TablePage* page = static_cast<TablePage*>(buffer_pool_manager_->FetchPage(p));
-    ASSERT(page!=nullptr,"A fetched page but nullptr!");
-    
     page->WLatch();
-    success = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    bool success = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
     page->WUnlatch();
-    
-    if(success){
+
+    free_space_map_->UpdatePage(p, free_space);
+    if (success) {
       // 里面修改了 rid
-      buffer_pool_manager_->UnpinPage(p, true);
+      guard.MarkDirty();
       return true;
     }
+  }
+  return AppendTuple(row, txn);
+}
 
-    last_p = p;
-    page_id_t next_ = page->GetNextPageId();
-
-    buffer_pool_manager_->UnpinPage(p, false);
-    p = next_;
+bool TableHeap::AppendTuple(Row &row, Txn *txn) {
+  std::lock_guard<std::mutex> append_guard(append_latch_);
+  page_id_t last_p = free_space_map_->GetLastPageId();
+  if (last_p != INVALID_PAGE_ID) {
+    // another insert may have appended a page meanwhile
+    WritePageGuard last_guard = buffer_pool_manager_->FetchPageWrite(last_p);
+    auto last_page = reinterpret_cast<TablePage *>(last_guard.GetPage());
+    bool success = last_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    free_space_map_->UpdatePage(last_p, last_page->GetFreeSpaceRemaining());
+    if (success) return true;
   }
   // 没有地方放得下，要新开
   page_id_t new_page_id;
-  auto new_page_ = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
-  // 这里也 pin 了，记得 unpin
-  if(new_page_ == nullptr) return false;
+  PageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+  if (!new_guard.IsValid()) return false;
+  auto new_page_ = reinterpret_cast<TablePage *>(new_guard.GetPage());
 
   new_page_->Init(new_page_id, last_p, log_manager_, txn);
-  if(last_p != INVALID_PAGE_ID) {
-    auto last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_p));
-    last_page->WLatch();
-    last_page->SetNextPageId(new_page_id);
-    last_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(last_p, true);
-  }
-  else {
+  new_guard.MarkDirty();
+  if (last_p != INVALID_PAGE_ID) {
+    WritePageGuard last_guard = buffer_pool_manager_->FetchPageWrite(last_p);
+    reinterpret_cast<TablePage *>(last_guard.GetPage())->SetNextPageId(new_page_id);
+  } else {
     // 这是第一页
     first_page_id_ = new_page_id;
   }
 
   new_page_->WLatch();
-  success = new_page_->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  bool success = new_page_->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_space = new_page_->GetFreeSpaceRemaining();
   new_page_->WUnlatch();
-  buffer_pool_manager_->UnpinPage(new_page_id, true);
-  return success;  
+  free_space_map_->AddPage(new_page_id, free_space);
+  return success;
+}
+
+bool TableHeap::BulkAppend(Row &row, PageGuard *page_guard, Txn *txn) {
+  uint32_t serialized_size = row.GetSerializedSize(schema_);
+  if (serialized_size >= TablePage::SIZE_MAX_ROW) return false;
+  if (!page_guard->IsValid()) {
+    // 先把表尾那一页填满
+    page_id_t last_p = free_space_map_->GetLastPageId();
+    if (last_p != INVALID_PAGE_ID) *page_guard = buffer_pool_manager_->FetchPageGuarded(last_p);
+  }
+  TablePage *page = nullptr;
+  if (page_guard->IsValid()) {
+    page = reinterpret_cast<TablePage *>(page_guard->GetPage());
+    page->WLatch();
+    bool success = page->AppendTuple(row, serialized_size, schema_);
+    page->WUnlatch();
+    if (success) {
+      page_guard->MarkDirty();
+      return true;
+    }
+  }
+  // 放不下了，新开一页接在后面
+  page_id_t new_page_id;
+  PageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+  if (!new_guard.IsValid()) return false;
+  auto new_page = reinterpret_cast<TablePage *>(new_guard.GetPage());
+  new_page->Init(new_page_id, page == nullptr ? INVALID_PAGE_ID : page->GetTablePageId(), log_manager_, txn);
+  new_guard.MarkDirty();
+  if (page != nullptr) {
+    page->WLatch();
+    page->SetNextPageId(new_page_id);
+    page->WUnlatch();
+    page_guard->MarkDirty();
+  } else {
+    first_page_id_ = new_page_id;
+  }
+  FinishBulkPage(page_guard);
+  free_space_map_->AddPage(new_page_id, new_page->GetFreeSpaceRemaining());
+  *page_guard = std::move(new_guard);
+
+  new_page->WLatch();
+  bool success = new_page->AppendTuple(row, serialized_size, schema_);
+  new_page->WUnlatch();
+  return success;
+}
+
+void TableHeap::FinishBulkPage(PageGuard *page_guard) {
+  if (!page_guard->IsValid()) return;
+  free_space_map_->UpdatePage(page_guard->GetPageId(),
+                              reinterpret_cast<TablePage *>(page_guard->GetPage())->GetFreeSpaceRemaining());
+  page_guard->Drop();
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the recovery.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  reinterpret_cast<TablePage *>(guard.GetPage())->MarkDelete(rid, txn, lock_manager_, log_manager_);
   return true;
 }
 
@@ -76,8 +135,9 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  * Zat Implement
  */
 bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if(page == nullptr) return false; // 不存在没法改
+  PageGuard guard = buffer_pool_manager_->FetchPageGuarded(rid.GetPageId());
+  if(!guard.IsValid()) return false; // 不存在没法改
+  auto page = reinterpret_cast<TablePage *>(guard.GetPage());
 
   Row old_row_;
   page->RLatch();
@@ -88,13 +148,15 @@ bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
   page->WLatch();
   bool success = page->UpdateTuple(row,&old_row_,schema_,txn,lock_manager_,log_manager_);
   page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(),success);
 
   if(success) {
+    guard.MarkDirty();
     row.SetRowId(rid);
+    free_space_map_->UpdatePage(rid.GetPageId(), page->GetFreeSpaceRemaining());
     return true;
   }
   else  {
+    guard.Drop();
     //说明原地写回失败，原来那个删掉，new一个插入
     if(!MarkDelete(rid,txn)) return false;// 删不掉直接回去（可能是线程有占用？）
     return InsertTuple(row,txn);
@@ -106,75 +168,81 @@ bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
  */
 void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   // Step1: Find the page which contains the tuple.
-  Page *raw = buffer_pool_manager_->FetchPage(rid.GetPageId());
-  assert(raw != nullptr);
-  auto page = reinterpret_cast<TablePage *>(raw);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
 
   // Step2: Delete the tuple from the page.  
-  page->WLatch();
+  auto page = reinterpret_cast<TablePage *>(guard.GetPage());
   page->ApplyDelete(rid, txn, log_manager_);
-  page->WUnlatch();
 
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // Step3: The space of the tuple can be taken by inserts.
+  free_space_map_->UpdatePage(rid.GetPageId(), page->GetFreeSpaceRemaining());
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
   // Rollback to delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  reinterpret_cast<TablePage *>(guard.GetPage())->RollbackDelete(rid, txn, log_manager_);
 }
 
 /**
- * Zat Implement 调用前记得page RLatch!
+ * Zat Implement
  */
 bool TableHeap::GetTuple(Row *row, Txn *txn) {
-  const RowId rid = row->GetRowId();
-  page_id_t page_id = rid.GetPageId();
-
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-
-  if (page == nullptr) return false;
-  bool ok = page->GetTuple(row, schema_, txn, lock_manager_);
-  buffer_pool_manager_->UnpinPage(page_id, false);
-
-  return ok;
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(row->GetRowId().GetPageId());
+  if (!guard.IsValid()) return false;
+  return reinterpret_cast<TablePage *>(guard.GetPage())->GetTuple(row, schema_, txn, lock_manager_);
 }
 
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
-    auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-    if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
-      DeleteTable(temp_table_page->GetNextPageId());
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id_t next_page_id;
+    {
+      PageGuard guard = buffer_pool_manager_->FetchPageGuarded(page_id);  // 删除table_heap
+      next_page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+    }
+    if (next_page_id != INVALID_PAGE_ID)
+      DeleteTable(next_page_id);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
     DeleteTable(first_page_id_);
+    free_space_map_->Destroy();
+  }
+}
+
+void TableHeap::OpenFreeSpaceMap(page_id_t fsm_page_id) {
+  if (fsm_page_id != INVALID_PAGE_ID) {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, fsm_page_id);
+    return;
+  }
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+  for (page_id_t p = first_page_id_; p != INVALID_PAGE_ID;) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(p);
+    ASSERT(guard.IsValid(), "TableHeap: failed to fetch page");
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+    free_space_map_->AddPage(p, page->GetFreeSpaceRemaining());
+    p = page->GetNextPageId();
   }
 }
 
 /**
  * Zat Implement 调用前记得page RLatch!
  */
-TableIterator TableHeap::Begin(Txn *txn) {
+TableIterator TableHeap::Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy,
+                               TableIterator::RowFilter filter) {
   page_id_t pid = first_page_id_;
   
   while (pid != INVALID_PAGE_ID) {
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid));
+    PageGuard guard = buffer_pool_manager_->FetchPageGuardedForRead(pid, strategy.get());
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
     RowId first_rid;
     if (page->GetFirstTupleRid(&first_rid)) {
-      buffer_pool_manager_->UnpinPage(pid, false);
-      
-      return TableIterator(this, first_rid, txn);
+      buffer_pool_manager_->PrefetchChain(page->GetNextPageId(), TablePage::NextPageIdOf);
+      return TableIterator(this, first_rid, txn, std::move(strategy), std::move(filter));
     }
-    
-    page_id_t next = page->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(pid, false);
-    pid = next;
+    pid = page->GetNextPageId();
   }
   
   return End();
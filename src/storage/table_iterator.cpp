@@ -6,17 +6,63 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn):table_heap_(table_heap),current_rid_(rid),txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy,
+                             RowFilter filter)
+    : table_heap_(table_heap), txn_(txn), current_rid_(rid), filter_(std::move(filter)), strategy_(std::move(strategy)) {
   if(rid == INVALID_ROWID) return ;
-  bool ok = table_heap_->GetTuple(&current_row_,txn_);
-  ASSERT(ok, "Failed to fetch tuple at table iterator init");
+  page_guard_ = FetchPage(rid.GetPageId());
+  SkipRejected();
+}
+
+PageGuard TableIterator::FetchPage(page_id_t page_id) {
+  return table_heap_->buffer_pool_manager_->FetchPageGuardedForRead(page_id, strategy_.get());
+}
+
+void TableIterator::LoadCurrentRow() {
+  current_row_.destroy();
+  current_row_.SetRowId(current_rid_);
+  auto page = reinterpret_cast<TablePage *>(page_guard_.GetPage());
+  page->RLatch();
+  bool ok = page->GetTuple(&current_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
+  page->RUnlatch();
+  ASSERT(ok, "TableIterator: GetTuple failed");
+  row_loaded_ = true;
+}
+
+bool TableIterator::Accept() {
+  row_loaded_ = false;
+  if (filter_ == nullptr) return true;
+  auto page = reinterpret_cast<TablePage *>(page_guard_.GetPage());
+  page->RLatch();
+  bool accepted = page->GetTupleView(current_rid_, table_heap_->schema_, &view_) && filter_(view_);
+  page->RUnlatch();
+  return accepted;
+}
+
+void TableIterator::SkipRejected() {
+  while (!(current_rid_ == INVALID_ROWID) && !Accept()) {
+    Step();
+  }
+}
+
+void TableIterator::Materialize(const std::vector<uint32_t> &columns, Row *row) {
+  auto page = reinterpret_cast<TablePage *>(page_guard_.GetPage());
+  page->RLatch();
+  bool ok = page->GetTupleView(current_rid_, table_heap_->schema_, &view_);
+  if (ok) view_.Materialize(columns, row);
+  page->RUnlatch();
+  ASSERT(ok, "TableIterator: tuple not found");
 }
 
 TableIterator::TableIterator(const TableIterator &other) {
   table_heap_  = other.table_heap_;
   txn_         = other.txn_;
   current_row_ = other.current_row_;
+  row_loaded_  = other.row_loaded_;
   current_rid_ = other.current_rid_;
+  filter_      = other.filter_;
+  strategy_    = other.strategy_;
+  if (other.page_guard_.IsValid()) page_guard_ = FetchPage(current_rid_.GetPageId());
 }
 
 TableIterator::~TableIterator() {
@@ -35,10 +81,12 @@ bool TableIterator::operator!=(const TableIterator &itr) const {
 }
 
 const Row &TableIterator::operator*() {
+  if (!row_loaded_) LoadCurrentRow();
   return current_row_;
 }
 
 Row *TableIterator::operator->() {
+  if (!row_loaded_) LoadCurrentRow();
   return &current_row_;
 }
 
@@ -46,7 +94,15 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   table_heap_  = itr.table_heap_;
   txn_         = itr.txn_;
   current_row_ = itr.current_row_;
-  current_rid_ = itr.current_rid_;  
+  row_loaded_  = itr.row_loaded_;
+  current_rid_ = itr.current_rid_;
+  filter_      = itr.filter_;
+  strategy_    = itr.strategy_;
+  if (itr.page_guard_.IsValid()) {
+    page_guard_ = FetchPage(current_rid_.GetPageId());
+  } else {
+    page_guard_.Drop();
+  }
   return *this;
 }
 
@@ -55,42 +111,43 @@ TableIterator &TableIterator::operator++() {
   // If already at end or uninitialized, do nothing
   if (current_rid_ == INVALID_ROWID || table_heap_ == nullptr) 
     return *this;
+  Step();
+  SkipRejected();
+  return *this;
+}
 
+/**
+ * The current page stays pinned between two steps, so stepping within a page neither fetches it again nor risks
+ * having it evicted in between.
+ */
+void TableIterator::Step() {
   auto bpm = table_heap_->buffer_pool_manager_;
-  page_id_t cur_page_id = current_rid_.GetPageId();
-  // Pin，免得查找下一条过程中数据改了
-  auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(cur_page_id));
+  auto page = reinterpret_cast<TablePage *>(page_guard_.GetPage());
   RowId next_rid;
   
   // 页内下一条
   if (page->GetNextTupleRid(current_rid_, &next_rid)) {
-    // Unpin after use
-    bpm->UnpinPage(cur_page_id, false);
     current_rid_ = next_rid;
-    bool ok = table_heap_->GetTuple(&current_row_, txn_);
-    ASSERT(ok, "TableIterator::operator++: GetTuple failed");
-    return *this;
+    return;
   }
   // 找下一页
   page_id_t next_page_id = page->GetNextPageId();
-  bpm->UnpinPage(cur_page_id, false);
   while (next_page_id != INVALID_PAGE_ID) {
-    auto page2 = reinterpret_cast<TablePage *>(bpm->FetchPage(next_page_id));
-    // Fetch时 Pin了
+    page_guard_.Drop();
+    page_guard_ = FetchPage(next_page_id);
+    auto page2 = reinterpret_cast<TablePage *>(page_guard_.GetPage());
+    page_id_t pid = page2->GetNextPageId();
     if (page2->GetFirstTupleRid(&next_rid)) {
-      bpm->UnpinPage(next_page_id, false);
+      // keep the pages after the one we just entered in flight
+      bpm->PrefetchChain(pid, TablePage::NextPageIdOf);
       current_rid_ = next_rid;
-      bool ok = table_heap_->GetTuple(&current_row_, txn_);
-      ASSERT(ok, "TableIterator::operator++: GetTuple failed on new page");
-      return *this;
+      return;
     }
-    page_id_t pid = page2->GetNextPageId();
-    bpm->UnpinPage(next_page_id, false);
     next_page_id = pid;
   }
   // 找不到，返回end
+  page_guard_.Drop();
   current_rid_ = INVALID_ROWID;
-  return *this;
 }
 
 // iter++
@@ -1,10 +1,19 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "buffer/buffer_pool_budget.h"
 #include "gtest/gtest.h"
+#include "page/bitmap_page.h"
 
 TEST(BufferPoolManagerTest, BinaryDataTest) {
   const std::string db_name = "bpm_test.db";
@@ -71,4 +80,902 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, ShardedInstancesTest) {
+  const std::string db_name = "bpm_sharded_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: every instance holds buffer_pool_size / num_instances frames, so page ids are spread round robin.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+  }
+  // Scenario: all the frames are pinned, the next page routed to instance 0 can not be cached.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->IsPageFree(buffer_pool_size));
+
+  // Scenario: unpin the pages of instance 1 only, a page routed to instance 0 still fails.
+  for (size_t i = 1; i < buffer_pool_size; i += num_instances) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_FALSE(bpm->CheckAllUnpinned());
+
+  // Scenario: once everything is unpinned, evicted pages are read back from disk with their content.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    if (i % num_instances != 1) {
+      EXPECT_TRUE(bpm->UnpinPage(i, true));
+    }
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  const std::string db_name = "bpm_guard_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  {
+    PageGuard guard = bpm->NewPageGuarded(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.GetPageId());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+
+    // moving hands the pin over without taking another one
+    PageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, moved.GetPage()->GetPinCount());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // a write guard leaves the page dirty, a read guard does not clear that
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    std::strcpy(guard.GetData(), "guarded");
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    EXPECT_STREQ("guarded", guard.GetData());
+    EXPECT_TRUE(guard.GetPage()->IsDirty());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // two readers share the page, assigning over a guard releases what it held first
+  {
+    ReadPageGuard first = bpm->FetchPageRead(page_id);
+    ReadPageGuard second = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, first.GetPage()->GetPinCount());
+    second = std::move(first);
+    EXPECT_FALSE(first.IsValid());
+    EXPECT_EQ(1, second.GetPage()->GetPinCount());
+    second.Drop();
+    EXPECT_FALSE(second.IsValid());
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+  }
+
+  // the page can be deleted once the guard is gone
+  {
+    PageGuard guard = bpm->FetchPageGuarded(page_id);
+    EXPECT_FALSE(bpm->DeletePage(page_id));
+  }
+  EXPECT_TRUE(bpm->DeletePage(page_id));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Not a correctness test: reports fetch/unpin throughput on resident pages for a growing number of threads, once with
+ * a single latch and once with the pool split into several instances. Hits do not take the latch of an instance, so
+ * here splitting the pool only adds the cost of picking the instance; it pays off when threads on several cores miss
+ * at once.
+ */
+TEST(BufferPoolManagerTest, ConcurrentFetchUnpinBenchmark) {
+  const std::string db_name = "bpm_bench_test.db";
+  const size_t buffer_pool_size = 1024;
+  const page_id_t num_pages = 512;
+  const size_t ops_per_thread = 50000;
+
+  for (size_t num_instances : {1, 16}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    page_id_t page_id_temp;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+      bpm->UnpinPage(page_id_temp, true);
+    }
+
+    for (size_t num_threads : {1, 2, 4, 8}) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+          std::mt19937 rng(t);
+          std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+          for (size_t i = 0; i < ops_per_thread; i++) {
+            page_id_t page_id = dist(rng);
+            ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+            bpm->UnpinPage(page_id, false);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << "[ BENCH    ] cores=" << std::thread::hardware_concurrency() << " instances=" << num_instances
+                << " threads=" << num_threads
+                << " fetch+unpin/s=" << static_cast<uint64_t>(num_threads * ops_per_thread / seconds) << std::endl;
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+/**
+ * Hits pin and unpin pages without the latch while misses evict pages under it, every fetched page must still hold the
+ * page it was asked for.
+ */
+TEST(BufferPoolManagerTest, ConcurrentEvictionTest) {
+  const std::string db_name = "bpm_eviction_test.db";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_pages = 48;
+  const size_t num_threads = 4;
+  const size_t ops_per_thread = 5000;
+
+  for (auto replacer_type : {ReplacerType::kLRU, ReplacerType::kCLOCK, ReplacerType::kLRUK, ReplacerType::k2Q}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, replacer_type);
+    page_id_t page_id_temp;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      auto *page = bpm->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id_temp;
+      bpm->UnpinPage(page_id_temp, true);
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        std::mt19937 rng(t);
+        for (size_t i = 0; i < ops_per_thread; i++) {
+          // most lookups go to a hot set which fits in the pool
+          auto page_id = static_cast<page_id_t>(i % 4 == 0 ? rng() % num_pages : rng() % (buffer_pool_size / 2));
+          auto *page = bpm->FetchPage(page_id);
+          ASSERT_NE(nullptr, page);
+          ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+          ASSERT_TRUE(bpm->UnpinPage(page_id, i % 8 == 0));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_GT(bpm->GetHitCount(), bpm->GetMissCount());
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+/**
+ * Not a correctness test: read-only point lookups over pages which are all cached, so that every lookup is a hit
+ * served without the latch of the instance. Throughput can only grow with the number of threads up to the number of
+ * cores, which is reported alongside.
+ */
+TEST(BufferPoolManagerTest, PointLookupBenchmark) {
+  const std::string db_name = "bpm_lookup_bench.db";
+  const size_t buffer_pool_size = 1024;
+  const page_id_t num_pages = 1024;
+  const size_t lookups_per_thread = 100000;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = page_id_temp;
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  for (size_t num_threads : {1, 4, 16}) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        std::mt19937 rng(t);
+        for (size_t i = 0; i < lookups_per_thread; i++) {
+          auto page_id = static_cast<page_id_t>(rng() % num_pages);
+          auto *page = bpm->FetchPageForRead(page_id);
+          ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ BENCH    ] cores=" << std::thread::hardware_concurrency() << " threads=" << num_threads
+              << " lookups/s=" << static_cast<uint64_t>(num_threads * lookups_per_thread / seconds) << std::endl;
+  }
+  EXPECT_EQ(0, bpm->GetMissCount());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Not a correctness test: replays point lookups over a small hot set mixed with periodic full scans of a heap larger
+ * than the pool, and reports the hit ratio reached by every replacement policy.
+ */
+TEST(BufferPoolManagerTest, ScanResistanceBenchmark) {
+  const std::string db_name = "bpm_replay_test.db";
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_hot_pages = 32;
+  const page_id_t num_heap_pages = 512;
+  const int num_rounds = 40;
+  const int lookups_per_round = 200;
+  const int fetches_per_scanned_page = 4;
+
+  const std::vector<std::pair<ReplacerType, std::string>> policies = {{ReplacerType::kLRU, "LRU"},
+                                                                      {ReplacerType::kCLOCK, "CLOCK"},
+                                                                      {ReplacerType::kLRUK, "LRU-2"},
+                                                                      {ReplacerType::k2Q, "2Q"}};
+  for (const auto &policy : policies) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, policy.first);
+    page_id_t page_id_temp;
+    for (page_id_t i = 0; i < num_hot_pages + num_heap_pages; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+      bpm->UnpinPage(page_id_temp, true);
+    }
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<page_id_t> hot_dist(1, num_hot_pages - 1);
+    std::uniform_int_distribution<page_id_t> heap_dist(num_hot_pages, num_hot_pages + num_heap_pages - 1);
+    auto touch = [&](page_id_t page_id) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    };
+    uint64_t lookup_hits = 0, lookup_misses = 0;
+    for (int round = 0; round < num_rounds; round++) {
+      // point lookups: root, one inner page, one leaf, then the tuple in the heap
+      uint64_t hits = bpm->GetHitCount(), misses = bpm->GetMissCount();
+      for (int i = 0; i < lookups_per_round; i++) {
+        touch(0);
+        touch(hot_dist(rng));
+        touch(hot_dist(rng));
+        touch(heap_dist(rng));
+      }
+      lookup_hits += bpm->GetHitCount() - hits;
+      lookup_misses += bpm->GetMissCount() - misses;
+      // every few rounds a select * walks the whole heap, fetching each page once per tuple
+      if (round % 2 == 1) {
+        for (page_id_t page_id = num_hot_pages; page_id < num_hot_pages + num_heap_pages; page_id++) {
+          for (int i = 0; i < fetches_per_scanned_page; i++) {
+            touch(page_id);
+          }
+        }
+      }
+    }
+    double total = bpm->GetHitCount() + bpm->GetMissCount();
+    std::cout << "[ BENCH    ] replacer=" << policy.second << " hit ratio=" << bpm->GetHitCount() / total
+              << " lookup hit ratio=" << lookup_hits / static_cast<double>(lookup_hits + lookup_misses) << std::endl;
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  const std::string db_name = "bpm_ring_test.db";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_hot_pages = 8;
+  const page_id_t num_pages = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // Scenario: the hot pages are the most recently used ones.
+  for (page_id_t i = 0; i < num_hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+
+  // Scenario: a scan over every other page through a ring of 4 frames, one page stays pinned while the ring cycles.
+  BufferAccessStrategy strategy(4);
+  ASSERT_NE(nullptr, bpm->FetchPage(num_hot_pages, &strategy));
+  for (page_id_t i = num_hot_pages + 1; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "scan-%d", i);
+    bpm->UnpinPage(i, true);
+  }
+  bpm->UnpinPage(num_hot_pages, false);
+
+  // Scenario: the hot pages survived the scan, fetching them again does not read the disk.
+  uint64_t misses = bpm->GetMissCount();
+  for (page_id_t i = 0; i < num_hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(misses, bpm->GetMissCount());
+
+  // Scenario: dirty pages recycled by the ring were written back.
+  for (page_id_t i = num_hot_pages + 1; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("scan-" + std::to_string(i), std::string(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlusherTest) {
+  const std::string db_name = "bpm_flusher_test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_pages = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "flushed-%d", page_id_temp);
+  }
+  // Page 0 stays pinned, every other page is dirty and unpinned.
+  for (page_id_t i = 1; i < num_pages; i++) {
+    bpm->UnpinPage(i, true);
+  }
+
+  // Scenario: the flusher writes the unpinned dirty pages back without anyone asking.
+  bpm->StartBackgroundFlusher(std::chrono::milliseconds(10), 1.0);
+  char data[PAGE_SIZE];
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  bool flushed = false;
+  while (!flushed && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    flushed = true;
+    for (page_id_t i = 1; i < num_pages && flushed; i++) {
+      disk_manager->ReadPage(i, data);
+      flushed = "flushed-" + std::to_string(i) == std::string(data);
+    }
+  }
+  bpm->StopBackgroundFlusher();
+  EXPECT_TRUE(flushed);
+
+  // Scenario: a pinned page is never written behind its user's back.
+  disk_manager->ReadPage(0, data);
+  EXPECT_EQ(std::string(), std::string(data));
+  bpm->UnpinPage(0, true);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FlushDuringWritesTest) {
+  const std::string db_name = "bpm_flush_writes_test.db";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_pages = 8;
+
+  DiskManager::RemoveFiles(db_name);
+  auto *disk_manager = new DiskManager(db_name);
+  ASSERT_TRUE(disk_manager->EnableChecksums());
+  auto *instance = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    page_id_t page_id = disk_manager->AllocatePage();
+    ASSERT_NE(nullptr, instance->NewPage(page_id));
+    EXPECT_TRUE(instance->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a writer keeps filling whole pages with one byte through lock-free hits while they are flushed, every
+  // page image which reaches the disk is one of the writer's and matches its checksum.
+  for (bool use_aio : {false, true}) {
+    auto aio = use_aio ? disk_manager->CreateAsyncIO(4) : nullptr;
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+      for (unsigned round = 0; !stop; round++) {
+        for (page_id_t i = 0; i < num_pages; i++) {
+          auto *page = instance->FetchPage(i);
+          ASSERT_NE(nullptr, page);
+          // byte by byte, so that the page is half written for a while
+          volatile char *data = page->GetData();
+          for (size_t j = 0; j < PAGE_SIZE; j++) {
+            data[j] = static_cast<char>(round + i);
+          }
+          instance->UnpinPage(i, true);
+        }
+      }
+    });
+    char data[PAGE_SIZE];
+    bool uniform = true;
+    for (int round = 0; round < 2000 && uniform; round++) {
+      instance->FlushDirtyPages(1.0, aio.get());
+      for (page_id_t i = 0; i < num_pages && uniform; i++) {
+        disk_manager->ReadPage(i, data);
+        uniform = std::all_of(data, data + PAGE_SIZE, [&data](char c) { return c == data[0]; });
+      }
+    }
+    stop = true;
+    writer.join();
+    EXPECT_TRUE(uniform);
+  }
+  EXPECT_TRUE(disk_manager->GetCorruptPages().empty());
+  EXPECT_TRUE(instance->CheckAllUnpinned());
+
+  delete instance;
+  delete disk_manager;
+  DiskManager::RemoveFiles(db_name);
+}
+
+// Pages of the prefetch test chain to the page two ids further, the id is stored at the start of the page.
+static page_id_t NextTestPageId(Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); }
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_pages = 48;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = i + 2 < num_pages ? i + 2 : INVALID_PAGE_ID;
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: a range read ahead is served from memory afterwards, with the content written before eviction.
+  bpm->PrefetchRange(0, 8);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());  // also waits for the prefetcher
+  uint64_t misses = bpm->GetMissCount();
+  for (page_id_t i = 0; i < 8; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i + 2, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(misses, bpm->GetMissCount());
+
+  // Scenario: nothing is read ahead along a chain until a depth is set.
+  bpm->PrefetchChain(20, NextTestPageId);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  ASSERT_NE(nullptr, bpm->FetchPage(20));
+  bpm->UnpinPage(20, false);
+  EXPECT_EQ(misses + 1, bpm->GetMissCount());
+
+  // Scenario: a chain is followed through the page content, up to the prefetch depth.
+  bpm->SetPrefetchDepth(4);
+  bpm->PrefetchChain(30, NextTestPageId);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  misses = bpm->GetMissCount();
+  for (page_id_t i = 30; i < 38; i += 2) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(misses, bpm->GetMissCount());
+  ASSERT_NE(nullptr, bpm->FetchPage(38));
+  bpm->UnpinPage(38, false);
+  EXPECT_EQ(misses + 1, bpm->GetMissCount());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, MappedReadTest) {
+  const std::string db_name = "bpm_mmap_test.db";
+  const size_t buffer_pool_size = 8;
+  const page_id_t num_pages = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  ASSERT_TRUE(disk_manager->EnableMappedReads());
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+    bpm->FlushPage(page_id_temp);
+  }
+
+  // Scenario: a page which is not cached is read in place from the mapping.
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPageForRead(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    if (i == 0) {
+      EXPECT_TRUE(page->IsMapped());
+    }
+    bpm->UnpinPage(i, false);
+  }
+
+  // Scenario: fetching a mapped page for writing copies it into its frame first, the write reaches the mapping once
+  // the page is flushed.
+  auto *page = bpm->FetchPageForRead(num_pages - 1);
+  ASSERT_TRUE(page->IsMapped());
+  ASSERT_EQ(page, bpm->FetchPage(num_pages - 1));
+  EXPECT_FALSE(page->IsMapped());
+  EXPECT_EQ("page-" + std::to_string(num_pages - 1), std::string(page->GetData()));
+  snprintf(page->GetData(), PAGE_SIZE, "changed");
+  bpm->UnpinPage(num_pages - 1, true);
+  bpm->UnpinPage(num_pages - 1, false);
+  bpm->FlushPage(num_pages - 1);
+  EXPECT_EQ(std::string("changed"), std::string(disk_manager->GetMappedPage(num_pages - 1)));
+
+  // Scenario: the mapping grows as extents are added.
+  const page_id_t extent_size = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  EXPECT_EQ(nullptr, disk_manager->GetMappedPage(extent_size));
+  while (disk_manager->AllocatePage() < extent_size) {
+  }
+  EXPECT_NE(nullptr, disk_manager->GetMappedPage(extent_size));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, MappedScanBenchmark) {
+  const std::string db_name = "bpm_mmap_bench.db";
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_pages = 2048;
+  const int num_passes = 4;
+
+  for (bool mapped : {false, true}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    if (mapped) {
+      ASSERT_TRUE(disk_manager->EnableMappedReads());
+    }
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    page_id_t page_id_temp;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      auto *page = bpm->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id_temp;
+      bpm->UnpinPage(page_id_temp, true);
+    }
+    for (page_id_t i = 0; i < num_pages; i++) {
+      bpm->FlushPage(i);
+    }
+
+    // every pass misses on every page, the pool is much smaller than the scanned range
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < num_passes; pass++) {
+      for (page_id_t i = 0; i < num_pages; i++) {
+        auto *page = bpm->FetchPageForRead(i);
+        ASSERT_NE(nullptr, page);
+        checksum += *reinterpret_cast<page_id_t *>(page->GetData());
+        bpm->UnpinPage(i, false);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(static_cast<uint64_t>(num_passes) * num_pages * (num_pages - 1) / 2, checksum);
+    std::cout << "[ BENCH    ] reads=" << (mapped ? "mmap" : "copy")
+              << " pages/s=" << static_cast<uint64_t>(num_passes * num_pages / elapsed.count()) << std::endl;
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warm_up_test.db";
+  const std::string dump_name = db_name + ".warm";
+  const size_t buffer_pool_size = 8;
+  const page_id_t num_pages = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // the hot pages are touched last, page 20 stays pinned
+  for (page_id_t i : {20, 21, 22, 23}) {
+    bpm->FetchPage(i);
+    if (i != 20) bpm->UnpinPage(i, false);
+  }
+
+  // Scenario: the dump lists every cached page, the pinned page first, then the most recently used pages of both
+  // instances in turn.
+  ASSERT_EQ(buffer_pool_size, bpm->DumpResidentPages(dump_name));
+  std::vector<page_id_t> head;
+  {
+    std::ifstream in(dump_name, std::ios::binary);
+    uint32_t words[2];
+    in.read(reinterpret_cast<char *>(words), sizeof(words));
+    head.resize(4);
+    in.read(reinterpret_cast<char *>(head.data()), static_cast<std::streamsize>(head.size() * sizeof(page_id_t)));
+  }
+  EXPECT_EQ(std::vector<page_id_t>({20, 23, 22, 21}), head);
+  bpm->UnpinPage(20, false);
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: a new pool reads the dumped pages back, fetching them afterwards never misses.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  bpm->StartWarmUp(dump_name);
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(buffer_pool_size, bpm->GetWarmUpCount());
+  EXPECT_FALSE(std::ifstream(dump_name).good());
+  for (page_id_t i : {20, 21, 22, 23}) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(4, bpm->GetHitCount());
+  EXPECT_EQ(0, bpm->GetMissCount());
+
+  // Scenario: pages freed since the dump are skipped, a dump larger than the pool is cut to its hottest pages.
+  ASSERT_EQ(buffer_pool_size, bpm->DumpResidentPages(dump_name));
+  delete bpm;
+  bpm = new BufferPoolManager(buffer_pool_size / 2, disk_manager, 2);
+  disk_manager->DeAllocatePage(20);
+  bpm->StartWarmUp(dump_name);
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(3, bpm->GetWarmUpCount());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  DiskManager::RemoveFiles(db_name);
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t num_instances = 2;
+  const size_t max_pool_size = 32;
+
+  for (ReplacerType replacer_type : {ReplacerType::kLRU, ReplacerType::k2Q}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(8, disk_manager, num_instances, replacer_type, max_pool_size);
+    EXPECT_EQ(8, bpm->GetPoolSize());
+    EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+
+    // Scenario: a grown pool caches all the pages at once.
+    EXPECT_EQ(max_pool_size, bpm->Resize(max_pool_size * 2));
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < max_pool_size; i++) {
+      auto *page = bpm->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    }
+    EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+
+    // Scenario: pinned frames cannot be given up, the shrink stops short.
+    EXPECT_EQ(max_pool_size, bpm->Resize(8));
+    for (page_id_t i = 0; i < static_cast<page_id_t>(max_pool_size); i++) {
+      EXPECT_TRUE(bpm->UnpinPage(i, true));
+    }
+
+    // Scenario: shrinking writes the dirty victims back, their content survives.
+    EXPECT_EQ(8, bpm->Resize(8));
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    for (page_id_t i = 0; i < static_cast<page_id_t>(max_pool_size); i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+
+    // Scenario: only 8 frames remain, the ninth pinned page cannot be cached. Growing again reuses retired frames.
+    std::vector<Page *> pinned;
+    for (page_id_t i = 0; i < 8; i++) {
+      pinned.push_back(bpm->FetchPage(i));
+      ASSERT_NE(nullptr, pinned.back());
+    }
+    EXPECT_EQ(nullptr, bpm->FetchPage(8));
+    EXPECT_EQ(16, bpm->Resize(16));
+    EXPECT_NE(nullptr, bpm->FetchPage(8));
+    EXPECT_TRUE(bpm->UnpinPage(8, false));
+    for (page_id_t i = 0; i < 8; i++) {
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+    delete bpm;
+    delete disk_manager;
+    remove(db_name.c_str());
+  }
+}
+
+TEST(BufferPoolManagerTest, BudgetTest) {
+  const std::string db_name = "bpm_budget_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *small = new BufferPoolManager(MIN_BUFFER_POOL_SIZE, disk_manager, 1, ReplacerType::kLRU, 100);
+  auto *large = new BufferPoolManager(MIN_BUFFER_POOL_SIZE, disk_manager, 2, ReplacerType::kLRU, 1000);
+  // no reserve, so that the shares do not depend on the memory of the machine running the test
+  BufferPoolBudget budget(1000, 0);
+
+  // Scenario: a single pool takes as much of the budget as it can hold.
+  budget.Register(large);
+  EXPECT_EQ(1000, large->GetPoolSize());
+
+  // Scenario: a second pool gets an even share, capped at its maximum, the rest stays with the first one.
+  budget.Register(small);
+  EXPECT_EQ(100, small->GetPoolSize());
+  EXPECT_EQ(900, large->GetPoolSize());
+  EXPECT_EQ(1000, budget.GetUsage());
+
+  // Scenario: a smaller budget shrinks both pools, none below the minimum.
+  budget.SetBudget(300);
+  EXPECT_EQ(100, small->GetPoolSize());
+  EXPECT_EQ(200, large->GetPoolSize());
+  budget.SetBudget(0);
+  EXPECT_EQ(MIN_BUFFER_POOL_SIZE, small->GetPoolSize());
+  EXPECT_EQ(MIN_BUFFER_POOL_SIZE, large->GetPoolSize());
+
+  // Scenario: under memory pressure the pools shrink below the budget, down to the minimum, and grow back after it.
+  budget.SetBudget(300);
+  budget.SetMemoryReserve(SIZE_MAX / 2);
+  EXPECT_EQ(MIN_BUFFER_POOL_SIZE, small->GetPoolSize());
+  EXPECT_EQ(MIN_BUFFER_POOL_SIZE, large->GetPoolSize());
+  budget.SetMemoryReserve(0);
+  EXPECT_EQ(100, small->GetPoolSize());
+  EXPECT_EQ(200, large->GetPoolSize());
+  // without pressure the periodic checks leave the pools as they are
+  budget.StartPressureMonitor(std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  budget.StopPressureMonitor();
+  EXPECT_EQ(300, budget.GetUsage());
+
+  // Scenario: a pool leaving hands its share over.
+  budget.SetBudget(600);
+  budget.Unregister(small);
+  EXPECT_EQ(600, large->GetPoolSize());
+  EXPECT_EQ(600, budget.GetUsage());
+
+  budget.Unregister(large);
+
+  // Scenario: a budget is set in whole megabytes, anything else is rejected instead of wrapping or truncating.
+  size_t frames = 0;
+  EXPECT_TRUE(BufferPoolBudget::ParseMegabytes("4", &frames));
+  EXPECT_EQ(4 * 1024 * 1024 / PAGE_SIZE, frames);
+  EXPECT_TRUE(BufferPoolBudget::ParseMegabytes("0", &frames));
+  EXPECT_EQ(0, frames);
+  for (const char *value : {"", "-5", "0.5", "+1", "1e3", "18446744073709551616", "17592186044416"}) {
+    EXPECT_FALSE(BufferPoolBudget::ParseMegabytes(value, &frames)) << value;
+  }
+
+  delete small;
+  delete large;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * A restarted pool serves a skewed workload, either cold or while a warm-up reads back the pages dumped by the pool
+ * before the restart. The db file is in the page cache, so a warm-up running alongside the lookups saves misses only
+ * on a machine with a spare core, see StartWarmUp.
+ */
+TEST(BufferPoolManagerTest, ColdStartBenchmark) {
+  const std::string db_name = "bpm_warm_up_bench.db";
+  const std::string dump_name = db_name + ".warm";
+  const size_t buffer_pool_size = 512;
+  const page_id_t num_pages = 4096;
+  const int num_lookups = 4096;
+
+  DiskManager::RemoveFiles(db_name);
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = page_id_temp;
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // the hot set is spread over the whole file
+  std::mt19937 rng(2024);
+  std::vector<page_id_t> hot_pages(buffer_pool_size);
+  for (auto &page_id : hot_pages) {
+    page_id = static_cast<page_id_t>(rng() % num_pages);
+  }
+  auto run_lookups = [&](BufferPoolManager *pool) {
+    std::mt19937 lookup_rng(7);
+    for (int i = 0; i < num_lookups; i++) {
+      page_id_t page_id = hot_pages[lookup_rng() % hot_pages.size()];
+      auto *page = pool->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      pool->UnpinPage(page_id, false);
+    }
+  };
+  delete bpm;
+
+  // every run dumps its pool for the next one, the lookups either race the warm-up or wait for it
+  enum class Start { kCold, kAlongside, kPreloaded };
+  for (auto mode : {Start::kCold, Start::kAlongside, Start::kPreloaded}) {
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    auto start = std::chrono::steady_clock::now();
+    if (mode != Start::kCold) bpm->StartWarmUp(dump_name);
+    if (mode == Start::kPreloaded) bpm->WaitForWarmUp();
+    std::chrono::duration<double> warm_up_elapsed = std::chrono::steady_clock::now() - start;
+    run_lookups(bpm);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    bpm->WaitForWarmUp();
+    const char *name = mode == Start::kCold ? "cold" : (mode == Start::kAlongside ? "alongside" : "preloaded");
+    std::cout << "[ BENCH    ] start=" << name << " misses=" << bpm->GetMissCount()
+              << " warmed=" << bpm->GetWarmUpCount() << " warm_up_us="
+              << (mode == Start::kPreloaded ? static_cast<uint64_t>(warm_up_elapsed.count() * 1e6) : 0)
+              << " lookups_us=" << static_cast<uint64_t>((elapsed - warm_up_elapsed).count() * 1e6) << std::endl;
+    if (mode == Start::kPreloaded) {
+      EXPECT_EQ(0, bpm->GetMissCount());
+    }
+    bpm->DumpResidentPages(dump_name);
+    delete bpm;
+  }
+  delete disk_manager;
+  DiskManager::RemoveFiles(db_name);
+}
@@ -56,6 +56,7 @@ TEST(CLOCKReplacerTest, ComprehensiveScenarios) {
   // Unpin(2) → 重新加入环，ref置1
   clock.Unpin(2);
   EXPECT_EQ(2U, clock.Size());
+  EXPECT_EQ(std::vector<frame_id_t>({3, 2}), clock.GetVictimOrder());
 
   // ——————————————————————————————————————————————
   // Victim
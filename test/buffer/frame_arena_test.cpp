@@ -0,0 +1,77 @@
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+TEST(FrameArenaTest, SampleTest) {
+  // Scenario: the frames are zeroed, aligned to a page and do not overlap.
+  for (bool huge_pages : {false, true}) {
+    const size_t num_frames = 2 * HUGE_PAGE_SIZE / PAGE_SIZE;
+    FrameArena arena(num_frames, huge_pages);
+    EXPECT_EQ(num_frames, arena.GetNumFrames());
+    if (!huge_pages) {
+      EXPECT_FALSE(arena.IsHugePageBacked());
+    }
+    for (size_t i = 0; i < num_frames; i++) {
+      char *frame = arena.GetFrame(i);
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(frame) % PAGE_SIZE);
+      EXPECT_EQ(0, frame[0]);
+      EXPECT_EQ(0, frame[PAGE_SIZE - 1]);
+      frame[0] = static_cast<char>(i);
+      frame[PAGE_SIZE - 1] = static_cast<char>(i);
+    }
+    for (size_t i = 0; i < num_frames; i++) {
+      EXPECT_EQ(static_cast<char>(i), arena.GetFrame(i)[0]);
+      EXPECT_EQ(static_cast<char>(i), arena.GetFrame(i)[PAGE_SIZE - 1]);
+    }
+    if (arena.IsHugePageBacked()) {
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % HUGE_PAGE_SIZE);
+    }
+  }
+
+  // Scenario: a pool too small for a huge page does not ask for one.
+  FrameArena small_arena(4, true);
+  EXPECT_FALSE(small_arena.IsHugePageBacked());
+}
+
+TEST(FrameArenaTest, BufferPoolFramesTest) {
+  const std::string db_name = "frame_arena_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: pages of the pool hand out page aligned data, the metadata sits on cache lines of its own.
+  page_id_t page_id;
+  Page *prev = nullptr;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page) % CACHE_LINE_SIZE);
+    if (prev != nullptr) {
+      EXPECT_NE(prev->GetData(), page->GetData());
+    }
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    prev = page;
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
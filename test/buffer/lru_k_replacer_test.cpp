@@ -0,0 +1,73 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1..6 are referenced once, frame 1 and 2 are referenced again after others.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.SetPage(i, i);
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Pin(2);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+  EXPECT_EQ(std::vector<frame_id_t>({3, 4, 5, 6, 1, 2}), lru_k_replacer.GetVictimOrder());
+
+  // Scenario: frames with a single reference go first, in order of their first reference.
+  int value;
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames can not be victims.
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+
+  // Scenario: frame 5 now has two references, the oldest second-to-last reference is evicted first.
+  lru_k_replacer.Unpin(5);
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2);
+
+  // Scenario: frame 0 is hit by two separate references, frame 1 many times in a row like a scanned heap page.
+  lru_k_replacer.SetPage(0, 0);
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.SetPage(1, 1);
+  for (int i = 0; i < 10; i++) {
+    lru_k_replacer.Pin(1);
+  }
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.Unpin(0);
+  lru_k_replacer.Unpin(1);
+
+  int value;
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: a frame loaded with a new page forgets the references of the previous one.
+  lru_k_replacer.SetPage(0, 2);
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.SetPage(3, 3);
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Unpin(0);
+  EXPECT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+}
@@ -14,6 +14,7 @@ TEST(LRUReplacerTest, SampleTest) {
   lru_replacer.Unpin(6);
   lru_replacer.Unpin(1);
   EXPECT_EQ(6, lru_replacer.Size());
+  EXPECT_EQ(std::vector<frame_id_t>({1, 2, 3, 4, 5, 6}), lru_replacer.GetVictimOrder());
 
   // Scenario: get three victims from the lru.
   int value;
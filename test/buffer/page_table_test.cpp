@@ -0,0 +1,53 @@
+#include "buffer/page_table.h"
+
+#include <random>
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+
+  // Scenario: pages map to their frames, unknown pages are not found.
+  page_table.Insert(10, 0);
+  page_table.Insert(11, 1);
+  page_table.Insert(0, 2);
+  EXPECT_EQ(0, page_table.Find(10));
+  EXPECT_EQ(1, page_table.Find(11));
+  EXPECT_EQ(2, page_table.Find(0));
+  EXPECT_EQ(INVALID_FRAME_ID, page_table.Find(12));
+
+  // Scenario: an erased page is gone, the pages probed past it are still found.
+  EXPECT_TRUE(page_table.Erase(10));
+  EXPECT_FALSE(page_table.Erase(10));
+  EXPECT_EQ(INVALID_FRAME_ID, page_table.Find(10));
+  EXPECT_EQ(1, page_table.Find(11));
+  EXPECT_EQ(2, page_table.Find(0));
+}
+
+TEST(PageTableTest, RandomOperationsTest) {
+  const size_t num_frames = 64;
+  PageTable page_table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 rng(42);
+
+  // a full table keeps colliding, every erase shifts entries back
+  for (int i = 0; i < 100000; i++) {
+    auto page_id = static_cast<page_id_t>(rng() % 512);
+    bool present = expected.count(page_id) != 0;
+    if (!present && expected.size() < num_frames) {
+      auto frame_id = static_cast<frame_id_t>(rng() % num_frames);
+      page_table.Insert(page_id, frame_id);
+      expected[page_id] = frame_id;
+    } else {
+      EXPECT_EQ(present, page_table.Erase(page_id));
+      expected.erase(page_id);
+    }
+    if (i % 1000 == 0) {
+      for (page_id_t p = 0; p < 512; p++) {
+        auto it = expected.find(p);
+        ASSERT_EQ(it == expected.end() ? INVALID_FRAME_ID : it->second, page_table.Find(p));
+      }
+    }
+  }
+}
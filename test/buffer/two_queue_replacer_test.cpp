@@ -0,0 +1,58 @@
+#include "buffer/two_queue_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(TwoQueueReplacerTest, SampleTest) {
+  // Kin = 2, Kout = 4
+  TwoQueueReplacer two_queue_replacer(8);
+  int value;
+
+  // Scenario: pages seen once stay in A1in, re-references there do not make them hot.
+  for (frame_id_t i = 0; i < 4; i++) {
+    two_queue_replacer.SetPage(i, 100 + i);
+    two_queue_replacer.Pin(i);
+    two_queue_replacer.Pin(i);
+    two_queue_replacer.Unpin(i);
+  }
+  EXPECT_EQ(4, two_queue_replacer.Size());
+  EXPECT_EQ(std::vector<frame_id_t>({0, 1, 2, 3}), two_queue_replacer.GetVictimOrder());
+
+  // Scenario: A1in is over its share, it is reclaimed in FIFO order and the page ids go to A1out.
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: page 100 comes back while remembered in A1out, it is promoted to Am.
+  two_queue_replacer.SetPage(0, 100);
+  two_queue_replacer.Pin(0);
+  two_queue_replacer.Unpin(0);
+  EXPECT_EQ(3, two_queue_replacer.Size());
+  EXPECT_EQ(std::vector<frame_id_t>({0, 2, 3}), two_queue_replacer.GetVictimOrder());
+
+  // Scenario: A1in is within its share, the LRU end of Am goes first, then A1in.
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: pinned frames are skipped.
+  two_queue_replacer.Pin(3);
+  EXPECT_EQ(0, two_queue_replacer.Size());
+  EXPECT_FALSE(two_queue_replacer.Victim(&value));
+  two_queue_replacer.Unpin(3);
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: a frame of A1in pinned and unpinned again goes back to its place, not to the tail.
+  for (frame_id_t i = 4; i < 7; i++) {
+    two_queue_replacer.SetPage(i, 200 + i);
+    two_queue_replacer.Unpin(i);
+  }
+  two_queue_replacer.Pin(4);
+  EXPECT_EQ(std::vector<frame_id_t>({5, 6}), two_queue_replacer.GetVictimOrder());
+  two_queue_replacer.Unpin(4);
+  EXPECT_EQ(std::vector<frame_id_t>({4, 5, 6}), two_queue_replacer.GetVictimOrder());
+  EXPECT_TRUE(two_queue_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+}
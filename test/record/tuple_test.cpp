@@ -1,10 +1,14 @@
+#include <chrono>
 #include <cstring>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "page/table_page.h"
 #include "record/field.h"
+#include "record/field_kernels.h"
 #include "record/row.h"
+#include "record/row_layout.h"
+#include "record/row_view.h"
 #include "record/schema.h"
 
 char *chars[] = {const_cast<char *>(""), const_cast<char *>("hello"), const_cast<char *>("world!"),
@@ -100,4 +104,226 @@ TEST(TupleTest, RowTest) {
   }
   ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
   table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
-}
\ No newline at end of file
+}
+TEST(TupleTest, RowViewTest) {
+  TablePage table_page;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("nickname", TypeId::kTypeChar, 64, 2, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 3, true, false)};
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188),
+                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                               Field(TypeId::kTypeChar), Field(TypeId::kTypeFloat, 19.99f)};
+  auto schema = std::make_shared<Schema>(columns);
+  Row row(fields);
+  table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+  RowView view;
+  ASSERT_TRUE(table_page.GetTupleView(row.GetRowId(), schema.get(), &view));
+  ASSERT_EQ(row.GetRowId(), view.GetRowId());
+  ASSERT_EQ(4, view.GetFieldCount());
+  // read out of order, so that the offsets are resolved past fields not read yet
+  ASSERT_EQ(CmpBool::kTrue, view.GetField(3).CompareEquals(fields[3]));
+  ASSERT_TRUE(view.IsNull(2));
+  ASSERT_TRUE(view.GetField(2).IsNull());
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (i != 2) {
+      ASSERT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields[i]));
+    }
+  }
+  Row projected;
+  view.Materialize({3, 0}, &projected);
+  ASSERT_EQ(row.GetRowId(), projected.GetRowId());
+  ASSERT_EQ(2, projected.GetFieldCount());
+  ASSERT_EQ(CmpBool::kTrue, projected.GetField(0)->CompareEquals(fields[3]));
+  ASSERT_EQ(CmpBool::kTrue, projected.GetField(1)->CompareEquals(fields[0]));
+  ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
+  ASSERT_FALSE(table_page.GetTupleView(row.GetRowId(), schema.get(), &view));
+}
+
+/** Write row in FORMAT_LEGACY, the way rows were written before RowLayout. */
+static uint32_t SerializeLegacy(Row &row, char *buf) {
+  uint32_t field_count = row.GetFieldCount();
+  uint32_t offset = sizeof(uint32_t) + (field_count + 7) / 8;
+  MACH_WRITE_UINT32(buf, field_count);
+  memset(buf + sizeof(uint32_t), 0, (field_count + 7) / 8);
+  for (uint32_t i = 0; i < field_count; i++) {
+    if (row.GetField(i)->IsNull()) {
+      buf[sizeof(uint32_t) + i / 8] |= (1 << (i % 8));
+    } else {
+      offset += row.GetField(i)->SerializeTo(buf + offset);
+    }
+  }
+  return offset;
+}
+
+TEST(TupleTest, RowLayoutTest) {
+  std::vector<Column *> columns = {new Column("name", TypeId::kTypeChar, 64, 0, true, false),
+                                   new Column("id", TypeId::kTypeInt, 1, false, false),
+                                   new Column("nickname", TypeId::kTypeChar, 64, 2, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 3, true, false),
+                                   new Column("city", TypeId::kTypeChar, 64, 4, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const RowLayout &layout = schema->GetLayout();
+  // header, 1 byte of null bitmap, id and account, then 3 entries of var offset table
+  ASSERT_TRUE(layout.IsFixed(1));
+  ASSERT_TRUE(layout.IsFixed(3));
+  ASSERT_FALSE(layout.IsFixed(0));
+  ASSERT_EQ(5, layout.GetSlotOffset(1));
+  ASSERT_EQ(9, layout.GetSlotOffset(3));
+  ASSERT_EQ(13, layout.GetSlotOffset(0));
+  ASSERT_EQ(17, layout.GetSlotOffset(2));
+  ASSERT_EQ(25, layout.GetVarDataOffset());
+
+  for (bool with_nulls : {false, true}) {
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false);
+    fields.emplace_back(TypeId::kTypeInt, 188);
+    if (with_nulls) {
+      fields.emplace_back(TypeId::kTypeChar);
+      fields.emplace_back(TypeId::kTypeFloat);
+    } else {
+      fields.emplace_back(TypeId::kTypeChar, const_cast<char *>("db"), strlen("db"), false);
+      fields.emplace_back(TypeId::kTypeFloat, 19.99f);
+    }
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>("hangzhou"), strlen("hangzhou"), false);
+    Row row(fields);
+    char buffer[PAGE_SIZE];
+    uint32_t size = row.SerializeTo(buffer, schema.get());
+    ASSERT_EQ(row.GetSerializedSize(schema.get()), size);
+    ASSERT_EQ(RowLayout::FORMAT_FIXED_FIRST, RowLayout::GetFormat(buffer));
+    ASSERT_EQ(5, RowLayout::GetFieldCount(buffer));
+    // the last char column is found without reading the others
+    uint32_t len;
+    uint32_t offset = layout.GetFieldOffset(buffer, 4, &len);
+    ASSERT_EQ("hangzhou", std::string(buffer + offset, len));
+
+    char legacy[PAGE_SIZE];
+    uint32_t legacy_size = SerializeLegacy(row, legacy);
+    for (auto buf : {buffer, legacy}) {
+      Row row2;
+      ASSERT_EQ(buf == buffer ? size : legacy_size, row2.DeserializeFrom(buf, schema.get()));
+      RowView view(buf, schema.get());
+      for (uint32_t i = 0; i < fields.size(); i++) {
+        ASSERT_EQ(fields[i].IsNull(), row2.GetField(i)->IsNull());
+        ASSERT_EQ(fields[i].IsNull(), view.GetField(i).IsNull());
+        if (!fields[i].IsNull()) {
+          ASSERT_EQ(CmpBool::kTrue, row2.GetField(i)->CompareEquals(fields[i]));
+          ASSERT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields[i]));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Not a correctness test: reads the last column of a wide row through a view, in the legacy format which has to
+ * walk the columns before it and in the fixed first format which finds it in O(1).
+ */
+TEST(TupleTest, LastColumnBenchmark) {
+  const uint32_t column_count = 64;
+  std::vector<Column *> columns;
+  std::vector<Field> fields;
+  char characters[16];
+  memset(characters, 'a', sizeof(characters));
+  for (uint32_t i = 0; i < column_count; i++) {
+    if (i % 2 == 0) {
+      columns.push_back(new Column("c" + std::to_string(i), TypeId::kTypeChar, 16, i, true, false));
+      fields.emplace_back(TypeId::kTypeChar, characters, 16, false);
+    } else {
+      columns.push_back(new Column("c" + std::to_string(i), TypeId::kTypeInt, i, true, false));
+      fields.emplace_back(TypeId::kTypeInt, static_cast<int32_t>(i));
+    }
+  }
+  auto schema = std::make_shared<Schema>(columns);
+  Row row(fields);
+  char buffer[PAGE_SIZE];
+  row.SerializeTo(buffer, schema.get());
+  char legacy[PAGE_SIZE];
+  SerializeLegacy(row, legacy);
+  const int reads = 1000000;
+  for (auto buf : {legacy, buffer}) {
+    RowView view;
+    Field expected(TypeId::kTypeInt, static_cast<int32_t>(column_count - 1));
+    int matches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++) {
+      view.Reset(buf, schema.get());
+      matches += view.GetField(column_count - 1).CompareEquals(expected) == CmpBool::kTrue;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(reads, matches);
+    std::cout << "[ BENCH    ] format=" << (buf == legacy ? "legacy" : "fixed-first") << " columns=" << column_count
+              << " reads/s=" << static_cast<uint64_t>(reads / seconds) << std::endl;
+  }
+}
+
+TEST(TupleTest, FieldKernelTest) {
+  char buffer[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (auto *fields : {int_fields, float_fields, char_fields}) {
+    size_t count = fields == int_fields ? 5 : 4;
+    TypeId type = fields[0].GetTypeId();
+    FieldCompareKernel compare = GetCompareKernel(type);
+    FieldSerializeKernel serialize = GetSerializeKernel(type);
+    for (size_t i = 0; i < count; i++) {
+      for (size_t j = 0; j < count; j++) {
+        int cmp = compare(fields[i], fields[j]);
+        ASSERT_EQ(fields[i].CompareLessThan(fields[j]) == CmpBool::kTrue, cmp < 0);
+        ASSERT_EQ(fields[i].CompareEquals(fields[j]) == CmpBool::kTrue, cmp == 0);
+        ASSERT_EQ(fields[i].CompareGreaterThan(fields[j]) == CmpBool::kTrue, cmp > 0);
+      }
+      uint32_t size = fields[i].SerializeTo(expected);
+      ASSERT_EQ(size, serialize(fields[i], buffer));
+      ASSERT_EQ(0, memcmp(expected, buffer, size));
+    }
+  }
+  for (auto &null_field : null_fields) {
+    ASSERT_EQ(0, GetSerializeKernel(null_field.GetTypeId())(null_field, buffer));
+  }
+}
+
+/**
+ * Not a correctness test: compares and serializes int, float and char fields through the virtual Type path of Field
+ * and through the kernels picked for their type.
+ */
+TEST(TupleTest, FieldKernelBenchmark) {
+  const int rounds = 2000000;
+  char buffer[PAGE_SIZE];
+  char long_chars[64];
+  memset(long_chars, 'a', sizeof(long_chars));
+  Field ints[] = {Field(TypeId::kTypeInt, 1), Field(TypeId::kTypeInt, 2)};
+  Field floats[] = {Field(TypeId::kTypeFloat, 1.0f), Field(TypeId::kTypeFloat, 2.0f)};
+  Field chars[] = {Field(TypeId::kTypeChar, long_chars, 63, false), Field(TypeId::kTypeChar, long_chars, 64, false)};
+  for (auto *fields : {ints, floats, chars}) {
+    TypeId type = fields[0].GetTypeId();
+    const char *name = type == TypeId::kTypeInt ? "int" : type == TypeId::kTypeFloat ? "float" : "char";
+    for (bool kernel : {false, true}) {
+      FieldCompareKernel compare = GetCompareKernel(type);
+      FieldSerializeKernel serialize = GetSerializeKernel(type);
+      int less = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < rounds; i++) {
+        const Field &lhs = fields[i & 1];
+        const Field &rhs = fields[(i + 1) & 1];
+        if (kernel) {
+          less += compare(lhs, rhs) < 0;
+        } else {
+          less += lhs.CompareLessThan(rhs) == CmpBool::kTrue;
+        }
+      }
+      double compare_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      ASSERT_EQ(rounds / 2, less);
+      uint64_t bytes = 0;
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < rounds; i++) {
+        bytes += kernel ? serialize(fields[i & 1], buffer) : fields[i & 1].SerializeTo(buffer);
+      }
+      double serialize_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      ASSERT_GT(bytes, 0);
+      std::cout << "[ BENCH    ] type=" << name << " path=" << (kernel ? "kernel" : "virtual")
+                << " compares/s=" << static_cast<uint64_t>(rounds / compare_seconds)
+                << " serializes/s=" << static_cast<uint64_t>(rounds / serialize_seconds) << std::endl;
+    }
+  }
+}
@@ -1,7 +1,17 @@
 #include "storage/disk_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "common/crc32c.h"
+#include "common/lz4.h"
 #include "gtest/gtest.h"
 
 TEST(DiskManagerTest, BitMapPageTest) {
@@ -56,4 +66,506 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+TEST(DiskManagerTest, ConcurrentPageIOTest) {
+  std::string db_name = "disk_concurrent_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const page_id_t num_pages = 256;
+  const int num_threads = 4;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+
+  // Scenario: threads write disjoint pages and read every page at the same time, without a shared cursor.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([disk_mgr, t] {
+      char data[PAGE_SIZE];
+      for (page_id_t i = t; i < num_pages; i += num_threads) {
+        memset(data, 0, PAGE_SIZE);
+        snprintf(data, PAGE_SIZE, "page-%d", i);
+        disk_mgr->WritePage(i, data);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  std::vector<int> mismatches(num_threads, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([disk_mgr, t, &mismatches] {
+      char data[PAGE_SIZE];
+      for (page_id_t i = 0; i < num_pages; i++) {
+        disk_mgr->ReadPage(i, data);
+        if ("page-" + std::to_string(i) != std::string(data)) mismatches[t]++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, mismatches[t]);
+  }
+  delete disk_mgr;
+
+  // Scenario: the pages and the allocation survive reopening the file.
+  disk_mgr = new DiskManager(db_name);
+  char data[PAGE_SIZE];
+  disk_mgr->ReadPage(num_pages - 1, data);
+  EXPECT_EQ("page-" + std::to_string(num_pages - 1), std::string(data));
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages - 1));
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, MetaCacheTest) {
+  std::string db_name = "disk_meta_cache_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const page_id_t num_pages = 100;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  // Scenario: the lowest freed page is handed out first.
+  disk_mgr->DeAllocatePage(70);
+  disk_mgr->DeAllocatePage(30);
+  EXPECT_TRUE(disk_mgr->IsPageFree(30));
+  EXPECT_EQ(30, disk_mgr->AllocatePage());
+  EXPECT_EQ(70, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+  disk_mgr->DeAllocatePage(5);
+
+  // Scenario: the cached meta and bitmap pages reach the file at a checkpoint.
+  disk_mgr->Checkpoint();
+  auto *reader = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(reader->GetMetaData());
+  EXPECT_EQ(num_pages, meta_page->GetAllocatedPages());
+  EXPECT_TRUE(reader->IsPageFree(5));
+  EXPECT_FALSE(reader->IsPageFree(num_pages));
+  // the reader must not write its copy back over the newer state
+  delete reader;
+
+  // Scenario: and at close, the reopened file continues where the allocation left off.
+  disk_mgr->DeAllocatePage(6);
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(num_pages - 1, meta_page->GetAllocatedPages());
+  EXPECT_EQ(5, disk_mgr->AllocatePage());
+  EXPECT_EQ(6, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages + 1, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ExtentBoundaryBenchmark) {
+  std::string db_name = "disk_extent_bench.db";
+  const int extent_nums = 3;
+  for (bool preallocate : {false, true}) {
+    remove(db_name.c_str());
+    auto *disk_mgr = new DiskManager(db_name, preallocate);
+    double boundary_max = 0, other_max = 0, total = 0;
+    const uint32_t num_pages = DiskManager::BITMAP_SIZE * extent_nums;
+    for (uint32_t i = 0; i < num_pages; i++) {
+      auto start = std::chrono::steady_clock::now();
+      page_id_t page_id = disk_mgr->AllocatePage();
+      double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      ASSERT_EQ(i, page_id);
+      total += elapsed;
+      if (i % DiskManager::BITMAP_SIZE == 0) {
+        boundary_max = std::max(boundary_max, elapsed);
+      } else {
+        other_max = std::max(other_max, elapsed);
+      }
+    }
+    // pages of a new extent read as zeros without ever being written
+    char data[PAGE_SIZE];
+    disk_mgr->ReadPage(num_pages - 1, data);
+    EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(data, PAGE_SIZE));
+    std::cout << "[ BENCH    ] preallocate=" << preallocate << " allocations=" << num_pages
+              << " mean_us=" << total / num_pages << " max_us_at_extent_boundary=" << boundary_max
+              << " max_us_elsewhere=" << other_max << std::endl;
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, MetaPageChainTest) {
+  std::string db_name = "disk_meta_chain_test.db";
+  const uint32_t extents_per_meta_page = DiskFileMetaPage::EXTENTS_PER_META_PAGE;
+  const page_id_t first_page_of_group = extents_per_meta_page * DiskManager::BITMAP_SIZE;
+
+  // Build a file whose first meta page counts as many full extents as it can hold, allocating them one page at a
+  // time would take seconds.
+  remove(db_name.c_str());
+  {
+    std::ofstream file(db_name, std::ios::binary);
+    char meta_data[PAGE_SIZE];
+    memset(meta_data, 0, PAGE_SIZE);
+    auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data);
+    meta_page->num_allocated_pages_ = first_page_of_group;
+    meta_page->num_extents_ = extents_per_meta_page;
+    char bitmap_data[PAGE_SIZE];
+    memset(bitmap_data, 0, PAGE_SIZE);
+    auto *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_data);
+    uint32_t offset;
+    while (bitmap->AllocatePage(offset)) {
+    }
+    for (uint32_t extent_index = 0; extent_index < extents_per_meta_page; extent_index++) {
+      meta_page->extent_used_page_[extent_index] = DiskManager::BITMAP_SIZE;
+      file.seekp((1 + static_cast<int64_t>(extent_index) * (1 + DiskManager::BITMAP_SIZE)) * PAGE_SIZE);
+      file.write(bitmap_data, PAGE_SIZE);
+    }
+    file.seekp(0);
+    file.write(meta_data, PAGE_SIZE);
+  }
+
+  // Scenario: allocation carries on past the extents the first meta page can count.
+  auto *disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(first_page_of_group, disk_mgr->AllocatePage());
+  EXPECT_EQ(first_page_of_group + 1, disk_mgr->AllocatePage());
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(extents_per_meta_page + 1, meta_page->GetExtentNums());
+  EXPECT_EQ(static_cast<uint32_t>(first_page_of_group + 2), meta_page->GetAllocatedPages());
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "first page of the second group");
+  disk_mgr->WritePage(first_page_of_group, data);
+  disk_mgr->DeAllocatePage(first_page_of_group - 1);
+  disk_mgr->DeAllocatePage(first_page_of_group + 1);
+  delete disk_mgr;
+
+  // Scenario: the counters kept by the second meta page survive reopening the file, and no page overlaps a meta or
+  // bitmap page.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_TRUE(disk_mgr->IsPageFree(first_page_of_group - 1));
+  EXPECT_FALSE(disk_mgr->IsPageFree(first_page_of_group));
+  EXPECT_TRUE(disk_mgr->IsPageFree(first_page_of_group + 1));
+  disk_mgr->ReadPage(first_page_of_group, data);
+  EXPECT_EQ("first page of the second group", std::string(data));
+  EXPECT_EQ(first_page_of_group - 1, disk_mgr->AllocatePage());
+  EXPECT_EQ(first_page_of_group + 1, disk_mgr->AllocatePage());
+  EXPECT_EQ(first_page_of_group + 2, disk_mgr->AllocatePage());
+
+  // Scenario: the last page id lies beyond 2^31 pages into the file.
+  snprintf(data, PAGE_SIZE, "last page");
+  disk_mgr->WritePage(MAX_VALID_PAGE_ID, data);
+  memset(data, 0, PAGE_SIZE);
+  disk_mgr->ReadPage(MAX_VALID_PAGE_ID, data);
+  EXPECT_EQ("last page", std::string(data));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+// Overwrite a few bytes of a page behind the disk manager's back, extent 0 starts after the meta and bitmap pages.
+static void CorruptPage(const std::string &db_name, page_id_t page_id) {
+  std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(static_cast<int64_t>(2 + page_id) * PAGE_SIZE + 100);
+  file.write("garbage", 7);
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  std::string db_name = "disk_checksum_test.db";
+  remove(db_name.c_str());
+  remove((db_name + ".crc").c_str());
+  const char *check = "123456789";
+  EXPECT_EQ(0xe3069283, Crc32c(check, 9));
+  EXPECT_EQ(0xe3069283, Crc32cSoftware(check, 9));
+
+  const page_id_t num_pages = 64;
+  auto *disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->EnableChecksums());
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page-%d", i);
+    disk_mgr->WritePage(i, data);
+  }
+  delete disk_mgr;
+  CorruptPage(db_name, 10);
+
+  // Scenario: reading a damaged page reports it, intact pages are not. An existing side file turns checksums on.
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->IsChecksumEnabled());
+  disk_mgr->ReadPage(9, data);
+  EXPECT_TRUE(disk_mgr->GetCorruptPages().empty());
+  disk_mgr->ReadPage(10, data);
+  EXPECT_EQ(std::vector<page_id_t>{10}, disk_mgr->GetCorruptPages());
+  // rewriting the page stamps a new checksum
+  disk_mgr->WritePage(10, data);
+  delete disk_mgr;
+
+  // Scenario: the scrubber finds damaged pages nobody reads.
+  CorruptPage(db_name, 40);
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->EnableChecksums());
+  disk_mgr->StartScrubber(std::chrono::milliseconds(1), 16);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (disk_mgr->GetScrubbedPageCount() < num_pages && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  disk_mgr->StopScrubber();
+  EXPECT_LE(num_pages, disk_mgr->GetScrubbedPageCount());
+  EXPECT_EQ(std::vector<page_id_t>{40}, disk_mgr->GetCorruptPages());
+  delete disk_mgr;
+
+  // Scenario: a stamp zeroed in the side file is reported like a damaged page, a page allocated but never written has
+  // no stamp yet and is not.
+  {
+    std::fstream file(db_name + ".crc", std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<int64_t>(2 + 20) * sizeof(uint32_t));
+    uint32_t zero = 0;
+    file.write(reinterpret_cast<const char *>(&zero), sizeof(zero));
+  }
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->EnableChecksums());
+  disk_mgr->ReadPage(20, data);
+  ASSERT_EQ(num_pages, disk_mgr->AllocatePage());
+  disk_mgr->ReadPage(num_pages, data);
+  EXPECT_EQ(std::vector<page_id_t>{20}, disk_mgr->GetCorruptPages());
+  delete disk_mgr;
+  remove(db_name.c_str());
+  remove((db_name + ".crc").c_str());
+}
+
+TEST(DiskManagerTest, ChecksumBenchmark) {
+  std::string db_name = "disk_checksum_bench.db";
+  const int num_rounds = 8192;
+  char data[PAGE_SIZE];
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    data[i] = static_cast<char>(i * 31);
+  }
+  // raw checksum throughput of the kernels
+  for (bool hardware : {false, true}) {
+    if (hardware && !Crc32cHardwareEnabled()) continue;
+    uint32_t crc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_rounds; i++) {
+      data[0] = static_cast<char>(i);
+      crc ^= hardware ? Crc32c(data, PAGE_SIZE) : Crc32cSoftware(data, PAGE_SIZE);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_NE(0u, crc | 1);
+    std::cout << "[ BENCH    ] crc32c=" << (hardware ? "sse4.2" : "table")
+              << " MB/s=" << static_cast<uint64_t>(num_rounds * (PAGE_SIZE / 1048576.0) / elapsed.count()) << std::endl;
+  }
+  // page I/O through the disk manager with and without checksums, the file stays in the page cache
+  const page_id_t num_pages = 2048;
+  for (bool checksums : {false, true}) {
+    remove(db_name.c_str());
+    remove((db_name + ".crc").c_str());
+    auto *disk_mgr = new DiskManager(db_name);
+    if (checksums) {
+      ASSERT_TRUE(disk_mgr->EnableChecksums());
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t i = 0; i < num_pages; i++) {
+      disk_mgr->WritePage(i, data);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (page_id_t i = 0; i < num_pages; i++) {
+      disk_mgr->ReadPage(i, data);
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_TRUE(disk_mgr->GetCorruptPages().empty());
+    std::chrono::duration<double> write_time = middle - start, read_time = end - middle;
+    std::cout << "[ BENCH    ] checksums=" << checksums
+              << " writes/s=" << static_cast<uint64_t>(num_pages / write_time.count())
+              << " reads/s=" << static_cast<uint64_t>(num_pages / read_time.count()) << std::endl;
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+  remove((db_name + ".crc").c_str());
+}
+
+// Fill a page like a table page half full of short varchar rows, the rest of the page is free space.
+static void FillHalfEmptyPage(char *data, std::mt19937 &rng) {
+  static const char *words[] = {"alice", "bob", "carol", "dave", "hangzhou", "zhejiang", "pending", "shipped"};
+  memset(data, 0, PAGE_SIZE);
+  int offset = 24;
+  while (offset < PAGE_SIZE / 2) {
+    offset += snprintf(data + offset, PAGE_SIZE - offset, "%u|%s|%s|", static_cast<unsigned>(rng() % 100000),
+                       words[rng() % 8], words[rng() % 8]);
+  }
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  std::string db_name = "disk_compression_test.db";
+  DiskManager::RemoveFiles(db_name);
+  std::mt19937 rng(0);
+  char data[PAGE_SIZE], noise[PAGE_SIZE], buffer[PAGE_SIZE], result[PAGE_SIZE];
+  for (char &c : noise) {
+    c = static_cast<char>(rng());
+  }
+
+  // Scenario: the codec round trips, gives up on noise and rejects truncated blocks.
+  FillHalfEmptyPage(data, rng);
+  int size = Lz4CompressBlock(data, PAGE_SIZE, buffer, PAGE_SIZE);
+  ASSERT_LT(0, size);
+  EXPECT_GT(PAGE_SIZE / 2, size);
+  EXPECT_EQ(PAGE_SIZE, Lz4DecompressBlock(buffer, size, result, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(data, result, PAGE_SIZE));
+  EXPECT_EQ(-1, Lz4DecompressBlock(buffer, size - 1, result, PAGE_SIZE));
+  EXPECT_EQ(0, Lz4CompressBlock(noise, PAGE_SIZE, buffer, PAGE_SIZE - DiskManager::SECTOR_SIZE));
+
+  // Scenario: pages written before compression is enabled are still read from the db file.
+  auto *disk_mgr = new DiskManager(db_name);
+  ASSERT_EQ(0, disk_mgr->AllocatePage());
+  disk_mgr->WritePage(0, noise);
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->EnableCompression());
+  disk_mgr->ReadPage(0, result);
+  EXPECT_EQ(0, memcmp(noise, result, PAGE_SIZE));
+
+  // Scenario: compressible pages take less space than their size, noise is stored as it is.
+  const page_id_t num_pages = 64;
+  std::vector<std::string> pages;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    if (i > 0) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    FillHalfEmptyPage(data, rng);
+    pages.emplace_back(i % 8 == 0 ? noise : data, PAGE_SIZE);
+    disk_mgr->WritePage(i, pages.back().data());
+  }
+  EXPECT_GT(static_cast<uint64_t>(num_pages) * PAGE_SIZE / 2, disk_mgr->GetCompressedBytes());
+  // rewriting a page with content of another size moves it to another run
+  pages[1] = std::string(noise, PAGE_SIZE);
+  disk_mgr->WritePage(1, noise);
+  pages[8] = pages[2];
+  disk_mgr->WritePage(8, pages[8].data());
+  for (page_id_t i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(i, result);
+    EXPECT_EQ(pages[i], std::string(result, PAGE_SIZE));
+  }
+  uint64_t compressed_bytes = disk_mgr->GetCompressedBytes();
+  disk_mgr->DeAllocatePage(num_pages - 1);
+  EXPECT_GT(compressed_bytes, disk_mgr->GetCompressedBytes());
+  delete disk_mgr;
+
+  // Scenario: the file stays compressed when reopened, and freed runs are reused instead of growing the file.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_TRUE(disk_mgr->IsCompressionEnabled());
+  for (page_id_t i = 0; i < num_pages - 1; i++) {
+    disk_mgr->ReadPage(i, result);
+    EXPECT_EQ(pages[i], std::string(result, PAGE_SIZE));
+  }
+  compressed_bytes = disk_mgr->GetCompressedBytes();
+  std::ifstream data_file(db_name + ".cdat", std::ios::binary | std::ios::ate);
+  auto file_size = static_cast<int64_t>(data_file.tellg());
+  EXPECT_EQ(num_pages - 1, disk_mgr->AllocatePage());
+  disk_mgr->WritePage(num_pages - 1, pages[2].data());
+  EXPECT_GT(compressed_bytes + PAGE_SIZE, disk_mgr->GetCompressedBytes());
+  delete disk_mgr;
+  std::ifstream data_file_after(db_name + ".cdat", std::ios::binary | std::ios::ate);
+  EXPECT_EQ(file_size, static_cast<int64_t>(data_file_after.tellg()));
+  DiskManager::RemoveFiles(db_name);
+}
+
+TEST(DiskManagerTest, CompressionBenchmark) {
+  std::string db_name = "disk_compression_bench.db";
+  const page_id_t num_pages = 2048;
+  for (bool compressed : {false, true}) {
+    DiskManager::RemoveFiles(db_name);
+    auto *disk_mgr = new DiskManager(db_name);
+    if (compressed) {
+      ASSERT_TRUE(disk_mgr->EnableCompression());
+    }
+    std::mt19937 rng(0);
+    char data[PAGE_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t i = 0; i < num_pages; i++) {
+      FillHalfEmptyPage(data, rng);
+      disk_mgr->WritePage(i, data);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      disk_mgr->ReadPage(i, data);
+      checksum += static_cast<unsigned char>(data[24]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_NE(0u, checksum);
+    uint64_t bytes = compressed ? disk_mgr->GetCompressedBytes() : static_cast<uint64_t>(num_pages) * PAGE_SIZE;
+    std::chrono::duration<double> write_time = middle - start, read_time = end - middle;
+    std::cout << "[ BENCH    ] compressed=" << compressed << " bytes_on_disk=" << bytes
+              << " ratio=" << static_cast<double>(num_pages) * PAGE_SIZE / bytes
+              << " writes/s=" << static_cast<uint64_t>(num_pages / write_time.count())
+              << " reads/s=" << static_cast<uint64_t>(num_pages / read_time.count()) << std::endl;
+    delete disk_mgr;
+  }
+  DiskManager::RemoveFiles(db_name);
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  std::string db_name = "disk_direct_io_test.db";
+  DiskManager::RemoveFiles(db_name);
+  const page_id_t num_pages = 32;
+  auto *disk_mgr = new DiskManager(db_name);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  // a page written through the page cache is still seen once O_DIRECT is on
+  char data[PAGE_SIZE] = "buffered";
+  disk_mgr->WritePage(0, data);
+  if (!disk_mgr->EnableDirectIO()) {
+    std::cout << "O_DIRECT is not supported here, skipping" << std::endl;
+    delete disk_mgr;
+    DiskManager::RemoveFiles(db_name);
+    return;
+  }
+  EXPECT_TRUE(disk_mgr->IsDirectIOEnabled());
+  EXPECT_FALSE(disk_mgr->EnableMappedReads());
+
+  // Scenario: aligned buffers go to the file as they are, unaligned ones are copied through an aligned buffer.
+  alignas(DiskManager::DIRECT_IO_ALIGNMENT) char aligned[PAGE_SIZE];
+  std::vector<char> storage(PAGE_SIZE + 1);
+  char *unaligned = storage.data() + 1;
+  ASSERT_TRUE(DiskManager::IsDirectIOAligned(aligned));
+  ASSERT_FALSE(DiskManager::IsDirectIOAligned(unaligned));
+  disk_mgr->ReadPage(0, aligned);
+  EXPECT_STREQ("buffered", aligned);
+  for (page_id_t i = 1; i < num_pages; i++) {
+    char *buffer = i % 2 == 0 ? aligned : unaligned;
+    memset(buffer, 0, PAGE_SIZE);
+    snprintf(buffer, PAGE_SIZE, "direct-%d", i);
+    disk_mgr->WritePage(i, buffer);
+  }
+  for (page_id_t i = 1; i < num_pages; i++) {
+    char *buffer = i % 2 == 0 ? unaligned : aligned;
+    disk_mgr->ReadPage(i, buffer);
+    EXPECT_EQ("direct-" + std::to_string(i), std::string(buffer));
+  }
+
+  // Scenario: both asynchronous backends work on the direct descriptor.
+  for (bool use_io_uring : {true, false}) {
+    auto aio = disk_mgr->CreateAsyncIO(8, use_io_uring);
+    int num_done = 0;
+    for (page_id_t i = 1; i < num_pages; i++) {
+      char *buffer = i % 2 == 0 ? aligned : unaligned;
+      memset(buffer, 'x', PAGE_SIZE);
+      aio->SubmitRead(i, buffer, [&num_done](bool ok) { num_done += ok ? 1 : 0; });
+      aio->Wait();
+      EXPECT_EQ("direct-" + std::to_string(i), std::string(buffer));
+    }
+    EXPECT_EQ(num_pages - 1, num_done);
+  }
+  delete disk_mgr;
+
+  // Scenario: the aligned meta and bitmap pages were checkpointed, the file reopens with O_DIRECT.
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->EnableDirectIO());
+  EXPECT_EQ(static_cast<uint32_t>(num_pages),
+            reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData())->GetAllocatedPages());
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages - 1));
+  disk_mgr->ReadPage(num_pages - 1, unaligned);
+  EXPECT_EQ("direct-" + std::to_string(num_pages - 1), std::string(unaligned));
+  delete disk_mgr;
+  DiskManager::RemoveFiles(db_name);
+}
@@ -1,10 +1,15 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
+#include "record/csv_reader.h"
 #include "record/field.h"
 #include "record/schema.h"
 #include "utils/utils.h"
@@ -48,6 +53,14 @@ TEST(TableHeapTest, TableHeapSampleTest) {
 
   ASSERT_EQ(row_nums, row_values.size());
   ASSERT_EQ(row_nums, size);
+  // a scan through a ring of frames, reading pages ahead, sees every row exactly once
+  bpm_->SetPrefetchDepth(DEFAULT_PREFETCH_DEPTH);
+  size_t scanned = 0;
+  for (auto it = table_heap->Begin(nullptr, std::make_shared<BufferAccessStrategy>()); it != table_heap->End(); ++it) {
+    ASSERT_TRUE(row_values.find(it->GetRowId().Get()) != row_values.end());
+    scanned++;
+  }
+  ASSERT_EQ(row_nums, scanned);
   for (auto row_kv : row_values) {
     size--;
     Row row(RowId(row_kv.first));
@@ -61,3 +74,386 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  size_t page_count = table_heap->GetPageCount();
+  ASSERT_GT(page_count, 1);
+
+  // Scenario: rows deleted from the first pages leave room, which the next inserts take instead of new pages.
+  for (int i = 0; i < row_nums / 4; i++) {
+    table_heap->ApplyDelete(rids[i], nullptr);
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t fsm_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+
+  // Scenario: the map is persisted, a reopened heap finds the free space without scanning.
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, fsm_page_id);
+  ASSERT_EQ(fsm_page_id, table_heap->GetFreeSpaceMapPageId());
+  ASSERT_EQ(page_count, table_heap->GetPageCount());
+  for (int i = 0; i < row_nums / 4; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  ASSERT_EQ(page_count, table_heap->GetPageCount());
+
+  size_t scanned = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    scanned++;
+  }
+  ASSERT_EQ(row_nums, scanned);
+  table_heap->DeleteTable();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/** Write a table page the way heaps were written before they had a free space map, with legacy rows. */
+static void WriteBaselinePage(char *data, page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id,
+                              int32_t first_id, uint32_t row_count) {
+  memset(data, 0, PAGE_SIZE);
+  MACH_WRITE_TO(page_id_t, data, page_id);
+  MACH_WRITE_TO(page_id_t, data + 8, prev_page_id);
+  MACH_WRITE_TO(page_id_t, data + 12, next_page_id);
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (uint32_t slot = 0; slot < row_count; slot++) {
+    // field count, one byte of null bitmap, then the id
+    char row[9];
+    MACH_WRITE_UINT32(row, 1);
+    row[4] = 0;
+    MACH_WRITE_TO(int32_t, row + 5, first_id + static_cast<int32_t>(slot));
+    free_space_pointer -= sizeof(row);
+    memcpy(data + free_space_pointer, row, sizeof(row));
+    // the slot array starts right after the 24 byte header
+    MACH_WRITE_UINT32(data + 24 + 8 * slot, free_space_pointer);
+    MACH_WRITE_UINT32(data + 28 + 8 * slot, sizeof(row));
+  }
+  MACH_WRITE_UINT32(data + 16, free_space_pointer);
+  MACH_WRITE_UINT32(data + 20, row_count);
+}
+
+TEST(TableHeapTest, BaselineLayoutTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const uint32_t rows_per_page = 100;
+
+  // Scenario: a heap of two pages written without a free space map is read as it was written.
+  page_id_t first_page_id;
+  page_id_t second_page_id;
+  ASSERT_NE(nullptr, bpm_->NewPage(first_page_id));
+  ASSERT_NE(nullptr, bpm_->NewPage(second_page_id));
+  WriteBaselinePage(bpm_->FetchPage(first_page_id)->GetData(), first_page_id, INVALID_PAGE_ID, second_page_id, 0,
+                    rows_per_page);
+  bpm_->UnpinPage(first_page_id, true);
+  bpm_->UnpinPage(first_page_id, true);
+  WriteBaselinePage(bpm_->FetchPage(second_page_id)->GetData(), second_page_id, first_page_id, INVALID_PAGE_ID,
+                    rows_per_page, rows_per_page);
+  bpm_->UnpinPage(second_page_id, true);
+  bpm_->UnpinPage(second_page_id, true);
+
+  TableHeap *table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  ASSERT_EQ(2, table_heap->GetPageCount());
+  int32_t expected_id = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    ASSERT_EQ(CmpBool::kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, expected_id)));
+    expected_id++;
+  }
+  ASSERT_EQ(2 * rows_per_page, expected_id);
+
+  // Scenario: the heap gets a free space map, inserts go to the pages with room and leave the old rows alone.
+  for (int32_t i = 0; i < 10; i++) {
+    Fields fields{Field(TypeId::kTypeInt, 1000 + i)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  ASSERT_EQ(2, table_heap->GetPageCount());
+  page_id_t fsm_page_id = table_heap->GetFreeSpaceMapPageId();
+  ASSERT_NE(INVALID_PAGE_ID, fsm_page_id);
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, fsm_page_id);
+  ASSERT_EQ(2, table_heap->GetPageCount());
+  Row row(RowId(first_page_id, 0));
+  ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+  ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 0)));
+  size_t scanned = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    scanned++;
+  }
+  ASSERT_EQ(2 * rows_per_page + 10, scanned);
+  table_heap->DeleteTable();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Not a correctness test: bulk inserts into an empty heap, which go to the last page of the heap through the free space
+ * map, so the insert rate does not drop as the heap grows.
+ */
+TEST(TableHeapTest, InsertBenchmark) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[32];
+  memset(characters, 'a', sizeof(characters));
+  for (int row_nums : {10000, 100000, 1000000}) {
+    remove(db_file_name.c_str());
+    auto disk_mgr_ = new DiskManager(db_file_name);
+    auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 32, true),
+                    Field(TypeId::kTypeFloat, 1.0f)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ BENCH    ] rows=" << row_nums << " pages=" << table_heap->GetPageCount()
+              << " inserts/s=" << static_cast<uint64_t>(row_nums / seconds) << std::endl;
+    delete table_heap;
+    delete bpm_;
+    delete disk_mgr_;
+    remove(db_file_name.c_str());
+  }
+}
+
+TEST(TableHeapTest, BulkInsertTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const int row_nums = 3000;
+  std::stringstream csv;
+  for (int i = 0; i < row_nums; i++) {
+    if (i % 100 == 0) {
+      csv << i << ",\"a \"\"quoted\"\", name\"," << std::endl;
+    } else {
+      csv << i << ",name-" << i << "," << i / 2.0f << std::endl;
+    }
+  }
+  // Scenario: a malformed line in the middle of the file stops the reader for good, the lines after it are not read.
+  csv << "3000,name,not-a-float" << std::endl;
+  csv << "3001,name,1.5" << std::endl;
+  csv << "3002,too,many,cells" << std::endl;
+
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  CsvReader reader(csv, schema.get());
+  std::vector<Row> rows;
+  std::vector<RowId> rids;
+  while (reader.ReadRows(&rows, 1000) > 0) {
+    ASSERT_TRUE(table_heap->BulkInsert(rows.begin(), rows.end(), &rids, nullptr));
+    rows.clear();
+  }
+  ASSERT_EQ(0, reader.ReadRows(&rows, 1000));
+  ASSERT_EQ(row_nums + 1, reader.GetLineNumber());
+  ASSERT_EQ(0, reader.GetError().rfind("line " + std::to_string(row_nums + 1) + ": ", 0));
+  ASSERT_EQ(row_nums, rids.size());
+
+  // Scenario: the rows are laid out in order over a single chain of pages, which a scan follows.
+  size_t scanned = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    ASSERT_EQ(rids[scanned].Get(), it->GetRowId().Get());
+    ASSERT_EQ(std::to_string(scanned), it->GetField(0)->toString());
+    scanned++;
+  }
+  ASSERT_EQ(row_nums, scanned);
+  Row row(rids[100]);
+  ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+  ASSERT_EQ("a \"quoted\", name", row.GetField(1)->toString());
+  ASSERT_TRUE(row.GetField(2)->IsNull());
+
+  // Scenario: a row-at-a-time insert after the load goes to the last page.
+  Fields fields{Field(TypeId::kTypeInt, row_nums), Field(TypeId::kTypeChar, const_cast<char *>("tail"), 4, true),
+                Field(TypeId::kTypeFloat, 1.0f)};
+  Row tail(fields);
+  size_t page_count = table_heap->GetPageCount();
+  ASSERT_TRUE(table_heap->InsertTuple(tail, nullptr));
+  ASSERT_EQ(page_count, table_heap->GetPageCount());
+
+  table_heap->DeleteTable();
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Not a correctness test: loads the same rows one at a time through InsertTuple and in batches through BulkInsert.
+ */
+TEST(TableHeapTest, BulkInsertBenchmark) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const int row_nums = 200000;
+  char characters[32];
+  memset(characters, 'a', sizeof(characters));
+  std::vector<Row> rows;
+  rows.reserve(row_nums);
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 32, true),
+                  Field(TypeId::kTypeFloat, 1.0f)};
+    rows.emplace_back(fields);
+  }
+  for (bool bulk : {false, true}) {
+    remove(db_file_name.c_str());
+    auto disk_mgr_ = new DiskManager(db_file_name);
+    auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+    TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+    auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+      std::vector<RowId> rids;
+      for (int i = 0; i < row_nums; i += BULK_LOAD_BATCH_SIZE) {
+        auto last = rows.begin() + std::min(i + BULK_LOAD_BATCH_SIZE, row_nums);
+        ASSERT_TRUE(table_heap->BulkInsert(rows.begin() + i, last, &rids, nullptr));
+      }
+    } else {
+      for (auto &row : rows) {
+        ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ BENCH    ] " << (bulk ? "bulk" : "row-at-a-time") << " rows=" << row_nums
+              << " pages=" << table_heap->GetPageCount() << " inserts/s=" << static_cast<uint64_t>(row_nums / seconds)
+              << std::endl;
+    delete table_heap;
+    delete bpm_;
+    delete disk_mgr_;
+    remove(db_file_name.c_str());
+  }
+}
+
+TEST(TableHeapTest, FilteredScanTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  const int row_nums = 10000;
+  char name[] = "minisql";
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  Field seven(TypeId::kTypeInt, 7), tail(TypeId::kTypeInt, 9990);
+  auto filter = [&](const RowView &view) {
+    Field id = view.GetField(0);
+    return id.CompareEquals(seven) == kTrue || id.CompareGreaterThanEquals(tail) == kTrue;
+  };
+  std::vector<int> ids;
+  for (auto itr = table_heap->Begin(nullptr, nullptr, filter); itr != table_heap->End(); ++itr) {
+    Row projected;
+    itr.Materialize({1, 0}, &projected);
+    ASSERT_EQ(itr.GetRowId(), projected.GetRowId());
+    ASSERT_EQ("minisql", projected.GetField(0)->toString());
+    ids.push_back(std::stoi(projected.GetField(1)->toString()));
+    // a row dereferenced from a filtered iterator is the whole tuple
+    ASSERT_EQ(2, itr->GetFieldCount());
+  }
+  std::vector<int> expected{7};
+  for (int i = 9990; i < row_nums; i++) expected.push_back(i);
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(expected, ids);
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Not a correctness test: compares a selective scan of a wide table which deserializes every row before evaluating
+ * its predicate with one which evaluates it on a view of the tuple and deserializes only the projected columns of the
+ * rows it accepts.
+ */
+TEST(TableHeapTest, SelectiveScanBenchmark) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const uint32_t column_count = 32;
+  std::vector<Column *> columns;
+  for (uint32_t i = 0; i < column_count; i++) {
+    if (i % 2 == 0) {
+      columns.push_back(new Column("c" + std::to_string(i), TypeId::kTypeInt, i, true, false));
+    } else {
+      columns.push_back(new Column("c" + std::to_string(i), TypeId::kTypeChar, 16, i, true, false));
+    }
+  }
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  const int row_nums = 50000;
+  char characters[16];
+  memset(characters, 'a', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields;
+    for (uint32_t j = 0; j < column_count; j++) {
+      if (j % 2 == 0) {
+        fields.emplace_back(TypeId::kTypeInt, i);
+      } else {
+        fields.emplace_back(TypeId::kTypeChar, characters, 16, false);
+      }
+    }
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  // select c0, c1 from t where c30 < 500, about 1% of the rows
+  Field bound(TypeId::kTypeInt, 500);
+  std::vector<uint32_t> projection{0, 1};
+  for (bool in_place : {false, true}) {
+    size_t matches = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (in_place) {
+      auto filter = [&bound](const RowView &view) { return view.GetField(30).CompareLessThan(bound) == kTrue; };
+      for (auto itr = table_heap->Begin(nullptr, nullptr, filter); itr != table_heap->End(); ++itr) {
+        Row output;
+        itr.Materialize(projection, &output);
+        matches++;
+      }
+    } else {
+      for (auto itr = table_heap->Begin(nullptr); itr != table_heap->End(); ++itr) {
+        if (itr->GetField(30)->CompareLessThan(bound) != kTrue) continue;
+        Fields output_fields{Field(*itr->GetField(0)), Field(*itr->GetField(1))};
+        Row output(output_fields);
+        matches++;
+      }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(500, matches);
+    std::cout << "[ BENCH    ] " << (in_place ? "row view" : "deserialize") << " columns=" << column_count
+              << " rows=" << row_nums << " rows/s=" << static_cast<uint64_t>(row_nums / seconds) << std::endl;
+  }
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}